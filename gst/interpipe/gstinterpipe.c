@@ -40,127 +40,409 @@
 GST_DEBUG_CATEGORY (gst_inter_pipe_debug);
 #define GST_CAT_DEFAULT gst_inter_pipe_debug
 
+typedef struct _GstInterPipeNodeEntry GstInterPipeNodeEntry;
 typedef struct _GstInterPipeListenerPriv GstInterPipeListenerPriv;
+
+/* A node name in use, registered by a node or requested by a listener.
+ * The entry is freed once neither is true, so the registry never keeps
+ * names that are no longer in use */
+struct _GstInterPipeNodeEntry
+{
+  gchar *name;
+  /* NULL until a node registers the name */
+  GstInterPipeINode *node;
+  /* Empty once the node starts finalizing, references are only taken
+   * through it */
+  GWeakRef node_ref;
+  /* The listeners that requested the name */
+  GList *listeners;
+};
+
 struct _GstInterPipeListenerPriv
 {
+  gint refcount;
   GstInterPipeIListener *listener;
-  const gchar *listen_to;
+
+  /* Serializes the switches of the listener. It is held while the nodes
+   * are called, the global locks never are */
+  GMutex switch_mutex;
+  /* Cleared when the listener leaves the listeners table */
+  gboolean registered;
+
+  /* The node requested by the listener, changed with switch_mutex and
+   * the global locks held */
+  GstInterPipeNodeEntry *entry;
+  /* The node the listener is attached to, NULL while waiting for it.
+   * Changed with switch_mutex and the listeners mutex held */
+  GstInterPipeINode *node;
 };
 
-/* Global mutexes for singletons */
+/* Global locks for singletons. Nodes are looked up far more often than
+ * they are added or removed, so readers share the lock. The listeners
+ * table and the listeners of an entry are protected by the listeners
+ * mutex, the entries and their node by the nodes lock. Entries
+ * are created and freed with both held, the listeners mutex first. A
+ * listener's switch_mutex is always taken before them */
 static GMutex listeners_mutex;
-static GMutex nodes_mutex;
+static GRWLock nodes_lock;
 
 static GHashTable *gst_inter_pipe_get_listeners ();
-static GHashTable *gst_inter_pipe_get_nodes ();
-static void gst_inter_pipe_notify_node_added (gpointer listener_name,
-    gpointer _listener, gpointer data);
-static void gst_inter_pipe_notify_node_removed (gpointer _listener_name,
-    gpointer _listener, gpointer data);
-static gboolean gst_inter_pipe_leave_listeners_table (GstInterPipeIListener *
-    listener);
-static gboolean gst_inter_pipe_leave_node_priv (GstInterPipeIListener *
-    listener);
+static GHashTable *gst_inter_pipe_get_entries ();
+static GHashTable *gst_inter_pipe_get_node_entries ();
+static GstInterPipeNodeEntry *gst_inter_pipe_entry_get (const gchar *
+    node_name);
+static void gst_inter_pipe_entry_release (GstInterPipeNodeEntry * entry);
+static GstInterPipeListenerPriv
+    * gst_inter_pipe_listener_priv_ref (GstInterPipeListenerPriv *
+    listener_priv);
+static void gst_inter_pipe_listener_priv_unref (GstInterPipeListenerPriv *
+    listener_priv);
+static GstInterPipeListenerPriv
+    * gst_inter_pipe_lock_listener (GstInterPipeIListener * listener,
+    gboolean create);
+static void gst_inter_pipe_unlock_listener (GstInterPipeListenerPriv *
+    listener_priv);
+static gboolean gst_inter_pipe_attach_locked (GstInterPipeListenerPriv *
+    listener_priv, const gchar * node_name, GstInterPipeINode * expected);
+static gboolean gst_inter_pipe_detach_locked (GstInterPipeListenerPriv *
+    listener_priv);
+static void gst_inter_pipe_index_listener (GstInterPipeListenerPriv *
+    listener_priv, GstInterPipeNodeEntry * entry);
+static void gst_inter_pipe_unindex_listener (GstInterPipeListenerPriv *
+    listener_priv);
+static GList *gst_inter_pipe_get_entry_listeners (GstInterPipeNodeEntry *
+    entry, GstInterPipeINode * attached);
+static void gst_inter_pipe_notify_node_added (gpointer _listener,
+    gpointer data);
+static void gst_inter_pipe_notify_node_removed (gpointer _listener,
+    gpointer data);
+static void gst_inter_pipe_leave_listeners_table (GstInterPipeListenerPriv *
+    listener_priv);
+static GstInterPipeListenerPriv
+    ** gst_inter_pipe_lock_listeners (GstInterPipeIListener ** listeners,
+    guint num_listeners);
+static gint gst_inter_pipe_compare_pointers (gconstpointer a,
+    gconstpointer b);
+static void gst_inter_pipe_detach_from_node (gpointer _listener,
+    gpointer data);
+static void gst_inter_pipe_free_names (gchar ** names, guint num_names);
+static void gst_inter_pipe_free_nodes (GstInterPipeINode ** nodes,
+    guint num_nodes);
+static gboolean gst_inter_pipe_commit_attach (GstInterPipeListenerPriv *
+    listener_priv, GstInterPipeNodeEntry * entry, GstInterPipeINode * node);
+static void gst_inter_pipe_restore_locked (GstInterPipeListenerPriv *
+    listener_priv, const gchar * node_name, GstInterPipeINode * node);
 
 static GHashTable *
 gst_inter_pipe_get_listeners (void)
 {
-  /* The listeners singleton */
+  /* The listeners singleton, keyed by the listener itself */
   static GHashTable *gst_inter_pipe_listeners = NULL;
 
   if (!gst_inter_pipe_listeners) {
-    gst_inter_pipe_listeners = g_hash_table_new (g_str_hash, g_str_equal);
+    gst_inter_pipe_listeners = g_hash_table_new (g_direct_hash,
+        g_direct_equal);
   }
   return gst_inter_pipe_listeners;
 }
 
 static GHashTable *
-gst_inter_pipe_get_nodes (void)
+gst_inter_pipe_get_entries (void)
 {
-  /* The nodes singleton */
-  static GHashTable *gst_inter_pipe_nodes = NULL;
+  /* The node names singleton, readers may race to create it */
+  static GHashTable *gst_inter_pipe_entries = NULL;
 
-  if (!gst_inter_pipe_nodes) {
-    gst_inter_pipe_nodes = g_hash_table_new (g_str_hash, g_str_equal);
+  if (g_once_init_enter (&gst_inter_pipe_entries)) {
+    g_once_init_leave (&gst_inter_pipe_entries,
+        g_hash_table_new (g_str_hash, g_str_equal));
   }
-  return gst_inter_pipe_nodes;
+  return gst_inter_pipe_entries;
+}
+
+static GHashTable *
+gst_inter_pipe_get_node_entries (void)
+{
+  /* The entry each node is registered under, to resolve node handles */
+  static GHashTable *gst_inter_pipe_node_entries = NULL;
+
+  if (g_once_init_enter (&gst_inter_pipe_node_entries)) {
+    g_once_init_leave (&gst_inter_pipe_node_entries,
+        g_hash_table_new (g_direct_hash, g_direct_equal));
+  }
+  return gst_inter_pipe_node_entries;
+}
+
+/* Must be called with the listeners mutex and the nodes writer lock held */
+static GstInterPipeNodeEntry *
+gst_inter_pipe_entry_get (const gchar * node_name)
+{
+  GHashTable *entries;
+  GstInterPipeNodeEntry *entry;
+
+  entries = gst_inter_pipe_get_entries ();
+
+  entry = g_hash_table_lookup (entries, node_name);
+  if (!entry) {
+    entry = g_new0 (GstInterPipeNodeEntry, 1);
+    entry->name = g_strdup (node_name);
+    g_hash_table_insert (entries, entry->name, entry);
+  }
+
+  return entry;
+}
+
+/* Must be called with the listeners mutex and the nodes writer lock held */
+static void
+gst_inter_pipe_entry_release (GstInterPipeNodeEntry * entry)
+{
+  if (entry->node || entry->listeners)
+    return;
+
+  g_hash_table_remove (gst_inter_pipe_get_entries (), entry->name);
+  g_weak_ref_clear (&entry->node_ref);
+  g_free (entry->name);
+  g_free (entry);
+}
+
+/* Must be called with the listeners mutex and the nodes writer lock held */
+static void
+gst_inter_pipe_index_listener (GstInterPipeListenerPriv * listener_priv,
+    GstInterPipeNodeEntry * entry)
+{
+  listener_priv->entry = entry;
+  entry->listeners = g_list_prepend (entry->listeners, listener_priv);
+}
+
+/* Must be called with the listeners mutex and the nodes writer lock held */
+static void
+gst_inter_pipe_unindex_listener (GstInterPipeListenerPriv * listener_priv)
+{
+  GstInterPipeNodeEntry *entry;
+
+  entry = listener_priv->entry;
+  if (!entry)
+    return;
+
+  entry->listeners = g_list_remove (entry->listeners, listener_priv);
+  listener_priv->entry = NULL;
+
+  gst_inter_pipe_entry_release (entry);
+}
+
+/* Must be called with the listeners mutex held. Returns the listeners
+ * of @entry attached to @attached, or the waiting ones if NULL */
+static GList *
+gst_inter_pipe_get_entry_listeners (GstInterPipeNodeEntry * entry,
+    GstInterPipeINode * attached)
+{
+  GstInterPipeListenerPriv *listener_priv;
+  GList *list;
+  GList *result = NULL;
+
+  for (list = entry->listeners; list; list = list->next) {
+    listener_priv = list->data;
+    if (listener_priv->node == attached)
+      result = g_list_prepend (result, g_object_ref (listener_priv->listener));
+  }
+
+  return result;
+}
+
+static GstInterPipeListenerPriv *
+gst_inter_pipe_listener_priv_ref (GstInterPipeListenerPriv * listener_priv)
+{
+  g_atomic_int_inc (&listener_priv->refcount);
+
+  return listener_priv;
+}
+
+static void
+gst_inter_pipe_listener_priv_unref (GstInterPipeListenerPriv * listener_priv)
+{
+  if (!g_atomic_int_dec_and_test (&listener_priv->refcount))
+    return;
+
+  g_mutex_clear (&listener_priv->switch_mutex);
+  g_free (listener_priv);
+}
+
+/* Returns the registry entry of @listener with its switch_mutex held,
+ * adding it to the listeners table if @create is set */
+static GstInterPipeListenerPriv *
+gst_inter_pipe_lock_listener (GstInterPipeIListener * listener,
+    gboolean create)
+{
+  GHashTable *listeners;
+  GstInterPipeListenerPriv *listener_priv;
+
+  listeners = gst_inter_pipe_get_listeners ();
+
+  while (TRUE) {
+    g_mutex_lock (&listeners_mutex);
+    listener_priv = g_hash_table_lookup (listeners, listener);
+    if (!listener_priv && create) {
+      /* The table holds the first reference */
+      listener_priv = g_new0 (GstInterPipeListenerPriv, 1);
+      listener_priv->refcount = 1;
+      listener_priv->listener = listener;
+      listener_priv->registered = TRUE;
+      g_mutex_init (&listener_priv->switch_mutex);
+      g_hash_table_insert (listeners, listener, listener_priv);
+    }
+    if (listener_priv)
+      gst_inter_pipe_listener_priv_ref (listener_priv);
+    g_mutex_unlock (&listeners_mutex);
+
+    if (!listener_priv)
+      return NULL;
+
+    g_mutex_lock (&listener_priv->switch_mutex);
+    if (listener_priv->registered)
+      return listener_priv;
+
+    /* It left the table while we waited for it */
+    g_mutex_unlock (&listener_priv->switch_mutex);
+    gst_inter_pipe_listener_priv_unref (listener_priv);
+  }
+}
+
+static void
+gst_inter_pipe_unlock_listener (GstInterPipeListenerPriv * listener_priv)
+{
+  g_mutex_unlock (&listener_priv->switch_mutex);
+  gst_inter_pipe_listener_priv_unref (listener_priv);
 }
 
 GstInterPipeINode *
 gst_inter_pipe_get_node (const gchar * node_name)
 {
-  GHashTable *nodes;
+  GstInterPipeNodeEntry *entry;
   GstInterPipeINode *value;
 
   g_return_val_if_fail (node_name != NULL, NULL);
 
-  g_mutex_lock (&nodes_mutex);
-  nodes = gst_inter_pipe_get_nodes ();
+  g_rw_lock_reader_lock (&nodes_lock);
 
-  value = (GstInterPipeINode *) g_hash_table_lookup (nodes, node_name);
-  g_mutex_unlock (&nodes_mutex);
+  entry = g_hash_table_lookup (gst_inter_pipe_get_entries (), node_name);
+  value = entry ? entry->node : NULL;
+  g_rw_lock_reader_unlock (&nodes_lock);
 
   return value;
 }
 
-gboolean
-gst_inter_pipe_listen_node (GstInterPipeIListener * listener,
-    const gchar * node_name)
+GstInterPipeINode *
+gst_inter_pipe_ref_node (const gchar * node_name)
 {
-  GstInterPipeINode *node;
-  GstInterPipeListenerPriv *listener_priv;
-  GHashTable *listeners;
-  const gchar *listener_name;
+  GstInterPipeNodeEntry *entry;
+  GstInterPipeINode *value = NULL;
 
-  g_return_val_if_fail (listener != NULL, FALSE);
-  g_return_val_if_fail (node_name != NULL, FALSE);
+  g_return_val_if_fail (node_name != NULL, NULL);
 
-  g_mutex_lock (&listeners_mutex);
+  /* Take the reference under the lock so the node can't be finalized
+     between the lookup and the ref */
+  g_rw_lock_reader_lock (&nodes_lock);
 
-  listeners = gst_inter_pipe_get_listeners ();
+  entry = g_hash_table_lookup (gst_inter_pipe_get_entries (), node_name);
+  if (entry && entry->node)
+    value = g_weak_ref_get (&entry->node_ref);
+  g_rw_lock_reader_unlock (&nodes_lock);
+
+  return value;
+}
+
+gchar *
+gst_inter_pipe_get_node_name (GstInterPipeINode * node)
+{
+  GstInterPipeNodeEntry *entry;
+  gchar *value;
+
+  g_return_val_if_fail (node != NULL, NULL);
+
+  g_rw_lock_reader_lock (&nodes_lock);
+
+  entry = g_hash_table_lookup (gst_inter_pipe_get_node_entries (), node);
+  value = entry ? g_strdup (entry->name) : NULL;
+  g_rw_lock_reader_unlock (&nodes_lock);
+
+  return value;
+}
+
+/* Must be called with the listener locked. If @expected is given the
+ * listener is only switched if @node_name still names it */
+static gboolean
+gst_inter_pipe_attach_locked (GstInterPipeListenerPriv * listener_priv,
+    const gchar * node_name, GstInterPipeINode * expected)
+{
+  GstInterPipeIListener *listener;
+  GstInterPipeINode *node = NULL;
+  GstInterPipeNodeEntry *entry;
+  const gchar *listener_name;
+
+  listener = listener_priv->listener;
   listener_name = gst_inter_pipe_ilistener_get_name (listener);
 
   GST_INFO ("listener %s listen to node %s", listener_name, node_name);
-  if (g_hash_table_contains (listeners, listener_name)) {
-    /*TODO: check if listener is the same listener from the list? */
-    listener_priv =
-        (GstInterPipeListenerPriv *) g_hash_table_lookup (listeners,
-        listener_name);
-    if (!g_strcmp0 (listener_priv->listen_to, node_name))
-      goto already_listen;
 
-    if (listener_priv->listen_to)
-      gst_inter_pipe_leave_node_priv (listener);
+  g_mutex_lock (&listeners_mutex);
+  g_rw_lock_writer_lock (&nodes_lock);
+
+  entry = gst_inter_pipe_entry_get (node_name);
+  if (expected && entry->node != expected)
+    goto not_registered;
 
-  } else {
-    listener_priv = g_malloc (sizeof (GstInterPipeListenerPriv));
-    listener_priv->listener = listener;
+  /*TODO: check if listener is the same listener from the list? */
+  if (listener_priv->entry == entry && listener_priv->node
+      && listener_priv->node == entry->node)
+    goto already_listen;
+
+  if (listener_priv->entry != entry) {
+    gst_inter_pipe_unindex_listener (listener_priv);
+    gst_inter_pipe_index_listener (listener_priv, entry);
   }
 
-  GST_INFO ("Adding new listener %s to node %s", listener_name, node_name);
+  /* Keeps the node alive while it is called without the locks */
+  if (entry->node)
+    node = g_weak_ref_get (&entry->node_ref);
 
-  node = gst_inter_pipe_get_node (node_name);
+  g_rw_lock_writer_unlock (&nodes_lock);
+  g_mutex_unlock (&listeners_mutex);
+
+  gst_inter_pipe_detach_locked (listener_priv);
+
+  GST_INFO ("Adding new listener %s to node %s", listener_name, node_name);
 
   /* If the node is not in the list we will notify later
      when it connects */
   if (node == NULL) {
     GST_INFO ("Node is not available yet, connecting later.");
-    listener_priv->listen_to = NULL;
-  } else {
-    if (!gst_inter_pipe_inode_add_listener (node, listener))
-      goto add_failed;
-    listener_priv->listen_to = node_name;
+    return TRUE;
   }
 
-  g_hash_table_insert (listeners, (gchar *) listener_name,
-      (gpointer) listener_priv);
+  if (!gst_inter_pipe_inode_add_listener (node, listener))
+    goto add_failed;
 
-  g_mutex_unlock (&listeners_mutex);
+  gst_inter_pipe_commit_attach (listener_priv, entry, node);
+  g_object_unref (node);
 
   return TRUE;
+
+not_registered:
+  {
+    GST_WARNING ("Node %p is no longer registered as %s", expected,
+        node_name);
+    gst_inter_pipe_entry_release (entry);
+    g_rw_lock_writer_unlock (&nodes_lock);
+    g_mutex_unlock (&listeners_mutex);
+
+    /* A listener that wasn't registered yet stays out of the registry */
+    if (!listener_priv->entry)
+      gst_inter_pipe_leave_listeners_table (listener_priv);
+    return FALSE;
+  }
 already_listen:
   {
     GST_INFO ("Already listening to node %s", node_name);
+    g_rw_lock_writer_unlock (&nodes_lock);
     g_mutex_unlock (&listeners_mutex);
     return TRUE;
   }
@@ -168,206 +450,514 @@ add_failed:
   {
     GST_WARNING ("Could not add listener %s to node %s", listener_name,
         node_name);
-    g_mutex_unlock (&listeners_mutex);
+    /* Keep the listener registered, waiting for the requested node */
+    g_object_unref (node);
     return FALSE;
   }
 }
 
+/* Must be called with the listener locked and indexed on @entry. The
+ * node may have been removed while it was adding the listener, removing
+ * the node only detaches the listeners it knew about */
 static gboolean
-gst_inter_pipe_leave_listeners_table (GstInterPipeIListener * listener)
+gst_inter_pipe_commit_attach (GstInterPipeListenerPriv * listener_priv,
+    GstInterPipeNodeEntry * entry, GstInterPipeINode * node)
 {
-  GstInterPipeListenerPriv *listener_priv;
-  GHashTable *listeners;
-  const gchar *listener_name;
+  gboolean attached;
 
-  listeners = gst_inter_pipe_get_listeners ();
-  listener_name = gst_inter_pipe_ilistener_get_name (listener);
+  g_mutex_lock (&listeners_mutex);
+  g_rw_lock_reader_lock (&nodes_lock);
+  attached = entry->node == node;
+  if (attached)
+    listener_priv->node = node;
+  g_rw_lock_reader_unlock (&nodes_lock);
+  g_mutex_unlock (&listeners_mutex);
 
-  listener_priv = g_hash_table_lookup (listeners, listener_name);
-  if (!g_hash_table_remove (listeners, listener_name))
-    return FALSE;
+  if (attached) {
+    gst_inter_pipe_ilistener_attached (listener_priv->listener, node);
+  } else {
+    GST_INFO ("Node %s was removed meanwhile, connecting later.",
+        entry->name);
+    gst_inter_pipe_inode_remove_listener (node, listener_priv->listener);
+  }
 
-  g_free (listener_priv);
+  return attached;
+}
 
-  return TRUE;
+/* Must be called with the listener locked. Puts the listener back on
+ * @node after a failed batch without replaying anything to it, the
+ * listener still has what it got from it. If @node_name names another
+ * node by now it is attached as a new listener, if @node_name is NULL
+ * the listener wasn't registered and leaves */
+static void
+gst_inter_pipe_restore_locked (GstInterPipeListenerPriv * listener_priv,
+    const gchar * node_name, GstInterPipeINode * node)
+{
+  GstInterPipeNodeEntry *entry;
+
+  /* Unregistered by the failed attach, or never switched away */
+  if (!listener_priv->registered || (node && listener_priv->node == node))
+    return;
+
+  gst_inter_pipe_detach_locked (listener_priv);
+
+  if (!node_name) {
+    gst_inter_pipe_leave_listeners_table (listener_priv);
+    return;
+  }
+
+  g_mutex_lock (&listeners_mutex);
+  g_rw_lock_writer_lock (&nodes_lock);
+
+  entry = gst_inter_pipe_entry_get (node_name);
+  if (!node || entry->node != node)
+    goto node_changed;
+
+  if (listener_priv->entry != entry) {
+    gst_inter_pipe_unindex_listener (listener_priv);
+    gst_inter_pipe_index_listener (listener_priv, entry);
+  }
+
+  g_rw_lock_writer_unlock (&nodes_lock);
+  g_mutex_unlock (&listeners_mutex);
+
+  if (!gst_inter_pipe_inode_rejoin_listener (node, listener_priv->listener))
+    goto rejoin_failed;
+
+  gst_inter_pipe_commit_attach (listener_priv, entry, node);
+
+  return;
+
+node_changed:
+  {
+    gst_inter_pipe_entry_release (entry);
+    g_rw_lock_writer_unlock (&nodes_lock);
+    g_mutex_unlock (&listeners_mutex);
+
+    gst_inter_pipe_attach_locked (listener_priv, node_name, NULL);
+    return;
+  }
+rejoin_failed:
+  {
+    /* Keep the listener registered, waiting for the node */
+    GST_WARNING ("Could not put listener %s back on node %s",
+        gst_inter_pipe_ilistener_get_name (listener_priv->listener),
+        node_name);
+    return;
+  }
 }
 
-static gboolean
-gst_inter_pipe_leave_node_priv (GstInterPipeIListener * listener)
+gboolean
+gst_inter_pipe_listen_node (GstInterPipeIListener * listener,
+    const gchar * node_name)
 {
-  GHashTable *listeners;
-  GstInterPipeINode *node;
   GstInterPipeListenerPriv *listener_priv;
-  const gchar *listener_name;
+  gboolean ret;
 
   g_return_val_if_fail (listener != NULL, FALSE);
+  g_return_val_if_fail (node_name != NULL, FALSE);
 
-  listeners = gst_inter_pipe_get_listeners ();
-  listener_name = gst_inter_pipe_ilistener_get_name (listener);
+  listener_priv = gst_inter_pipe_lock_listener (listener, TRUE);
+  ret = gst_inter_pipe_attach_locked (listener_priv, node_name, NULL);
+  gst_inter_pipe_unlock_listener (listener_priv);
 
-  listener_priv =
-      (GstInterPipeListenerPriv *) g_hash_table_lookup (listeners,
-      listener_name);
-  if (!listener_priv)
-    goto no_listener;
+  return ret;
+}
+
+gboolean
+gst_inter_pipe_listen_inode (GstInterPipeIListener * listener,
+    GstInterPipeINode * node)
+{
+  GstInterPipeListenerPriv *listener_priv;
+  gboolean ret;
+  gchar *node_name;
 
-  if (listener_priv->listen_to) {
-    GST_INFO ("listener %s leaving node %s", listener_name,
-        listener_priv->listen_to);
+  g_return_val_if_fail (listener != NULL, FALSE);
+  g_return_val_if_fail (node != NULL, FALSE);
 
-    node = gst_inter_pipe_get_node (listener_priv->listen_to);
-    if (node == NULL)
-      goto no_node;
+  node_name = gst_inter_pipe_get_node_name (node);
+  if (!node_name) {
+    GST_WARNING ("Node %p is not registered", node);
+    return FALSE;
+  }
 
-    if (!gst_inter_pipe_inode_remove_listener (node, listener))
-      goto remove_error;
+  listener_priv = gst_inter_pipe_lock_listener (listener, TRUE);
+  ret = gst_inter_pipe_attach_locked (listener_priv, node_name, node);
+  gst_inter_pipe_unlock_listener (listener_priv);
+
+  g_free (node_name);
+
+  return ret;
+}
 
+static void
+gst_inter_pipe_free_names (gchar ** names, guint num_names)
+{
+  guint i;
+
+  for (i = 0; i < num_names; i++)
+    g_free (names[i]);
+  g_free (names);
+}
+
+static void
+gst_inter_pipe_free_nodes (GstInterPipeINode ** nodes, guint num_nodes)
+{
+  guint i;
+
+  for (i = 0; i < num_nodes; i++) {
+    if (nodes[i])
+      g_object_unref (nodes[i]);
+  }
+  g_free (nodes);
+}
+
+static gint
+gst_inter_pipe_compare_pointers (gconstpointer a, gconstpointer b)
+{
+  gconstpointer pa = *(gconstpointer *) a;
+  gconstpointer pb = *(gconstpointer *) b;
+
+  return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+/* Listeners are always locked in the same order, so two batches can't
+ * wait on each other */
+static GstInterPipeListenerPriv **
+gst_inter_pipe_lock_listeners (GstInterPipeIListener ** listeners,
+    guint num_listeners)
+{
+  GstInterPipeListenerPriv **privs;
+  GPtrArray *order;
+  guint i, j;
+
+  order = g_ptr_array_sized_new (num_listeners);
+  for (i = 0; i < num_listeners; i++)
+    g_ptr_array_add (order, listeners[i]);
+  g_ptr_array_sort (order, gst_inter_pipe_compare_pointers);
+
+  for (i = 1; i < num_listeners; i++) {
+    if (g_ptr_array_index (order, i) == g_ptr_array_index (order, i - 1))
+      goto duplicated;
+  }
+
+  privs = g_new0 (GstInterPipeListenerPriv *, num_listeners);
+  for (i = 0; i < num_listeners; i++) {
+    j = 0;
+    while (listeners[j] != g_ptr_array_index (order, i))
+      j++;
+    privs[j] = gst_inter_pipe_lock_listener (listeners[j], TRUE);
   }
+  g_ptr_array_free (order, TRUE);
+
+  return privs;
+
+duplicated:
+  {
+    GST_WARNING ("Listener %s is switched twice",
+        gst_inter_pipe_ilistener_get_name (g_ptr_array_index (order, i)));
+    g_ptr_array_free (order, TRUE);
+    return NULL;
+  }
+}
+
+gboolean
+gst_inter_pipe_listen_inodes (GstInterPipeIListener ** listeners,
+    GstInterPipeINode ** nodes, guint num_listeners)
+{
+  GstInterPipeListenerPriv **privs = NULL;
+  gchar **node_names;
+  gchar **previous;
+  GstInterPipeINode **previous_nodes;
+  guint i;
+  guint switched = 0;
+
+  g_return_val_if_fail (listeners != NULL, FALSE);
+  g_return_val_if_fail (nodes != NULL, FALSE);
+
+  node_names = g_new0 (gchar *, num_listeners);
+  previous = g_new0 (gchar *, num_listeners);
+  previous_nodes = g_new0 (GstInterPipeINode *, num_listeners);
+
+  /* Resolve every handle before touching any listener */
+  for (i = 0; i < num_listeners; i++) {
+    node_names[i] = gst_inter_pipe_get_node_name (nodes[i]);
+    if (!node_names[i])
+      goto not_registered;
+  }
+
+  privs = gst_inter_pipe_lock_listeners (listeners, num_listeners);
+  if (!privs)
+    goto duplicated;
+
+  for (switched = 0; switched < num_listeners; switched++) {
+    GstInterPipeListenerPriv *listener_priv = privs[switched];
+
+    /* The weak reference is empty if the node is already finalizing */
+    previous[switched] = g_strdup (listener_priv->entry ?
+        listener_priv->entry->name : NULL);
+    if (listener_priv->node)
+      previous_nodes[switched] =
+          g_weak_ref_get (&listener_priv->entry->node_ref);
+    if (!gst_inter_pipe_attach_locked (listener_priv, node_names[switched],
+            nodes[switched]))
+      goto switch_failed;
+  }
+
+  for (i = 0; i < num_listeners; i++)
+    gst_inter_pipe_unlock_listener (privs[i]);
+
+  g_free (privs);
+  gst_inter_pipe_free_names (node_names, num_listeners);
+  gst_inter_pipe_free_names (previous, num_listeners);
+  gst_inter_pipe_free_nodes (previous_nodes, num_listeners);
 
   return TRUE;
 
-no_listener:
+not_registered:
   {
-    GST_WARNING ("Listener is not in the connected listeners list");
+    GST_WARNING ("Node %p is not registered, no listener was switched",
+        nodes[i]);
+    gst_inter_pipe_free_names (node_names, num_listeners);
+    gst_inter_pipe_free_names (previous, num_listeners);
+    gst_inter_pipe_free_nodes (previous_nodes, num_listeners);
+    return FALSE;
+  }
+duplicated:
+  {
+    GST_WARNING ("No listener was switched");
+    gst_inter_pipe_free_names (node_names, num_listeners);
+    gst_inter_pipe_free_names (previous, num_listeners);
+    gst_inter_pipe_free_nodes (previous_nodes, num_listeners);
     return FALSE;
   }
-no_node:
+switch_failed:
   {
-    GST_WARNING ("Node %s not found. Could not leave node.",
-        listener_priv->listen_to);
-    listener_priv->listen_to = NULL;
+    GST_WARNING ("Could not switch listener %s, rolling back %u listeners",
+        gst_inter_pipe_ilistener_get_name (listeners[switched]), switched);
+
+    /* Put every listener back where it was, including the failed one */
+    for (i = 0; i <= switched; i++)
+      gst_inter_pipe_restore_locked (privs[i], previous[i], previous_nodes[i]);
+    for (i = 0; i < num_listeners; i++)
+      gst_inter_pipe_unlock_listener (privs[i]);
+
+    g_free (privs);
+    gst_inter_pipe_free_names (node_names, num_listeners);
+    gst_inter_pipe_free_names (previous, num_listeners);
+    gst_inter_pipe_free_nodes (previous_nodes, num_listeners);
     return FALSE;
   }
+}
+
+/* Must be called with the listener locked */
+static void
+gst_inter_pipe_leave_listeners_table (GstInterPipeListenerPriv *
+    listener_priv)
+{
+  g_mutex_lock (&listeners_mutex);
+  g_rw_lock_writer_lock (&nodes_lock);
+
+  g_hash_table_remove (gst_inter_pipe_get_listeners (),
+      listener_priv->listener);
+  gst_inter_pipe_unindex_listener (listener_priv);
+  listener_priv->registered = FALSE;
+
+  g_rw_lock_writer_unlock (&nodes_lock);
+  g_mutex_unlock (&listeners_mutex);
+
+  /* Drop the reference of the table, the caller still holds one */
+  gst_inter_pipe_listener_priv_unref (listener_priv);
+}
+
+/* Must be called with the listener locked */
+static gboolean
+gst_inter_pipe_detach_locked (GstInterPipeListenerPriv * listener_priv)
+{
+  GstInterPipeINode *node;
+  const gchar *listener_name;
+
+  node = listener_priv->node;
+  if (!node)
+    return TRUE;
+
+  listener_name = gst_inter_pipe_ilistener_get_name (listener_priv->listener);
+  GST_INFO ("listener %s leaving node %p", listener_name, node);
+
+  g_mutex_lock (&listeners_mutex);
+  listener_priv->node = NULL;
+  g_mutex_unlock (&listeners_mutex);
+  gst_inter_pipe_ilistener_attached (listener_priv->listener, NULL);
+
+  /* Removing the node detaches its listeners first, so it is still
+   * alive here */
+  if (!gst_inter_pipe_inode_remove_listener (node, listener_priv->listener))
+    goto remove_error;
+
+  return TRUE;
+
 remove_error:
   {
     GST_WARNING
-        ("The listener %s was not listening to %s, there's something very wrong",
-        listener_name, listener_priv->listen_to);
-    listener_priv->listen_to = NULL;
+        ("The listener %s was not listening to %p, there's something very wrong",
+        listener_name, node);
     return FALSE;
   }
-
 }
 
 gboolean
 gst_inter_pipe_leave_node (GstInterPipeIListener * listener)
 {
-  gboolean ret = TRUE;
+  GstInterPipeListenerPriv *listener_priv;
+  gboolean ret;
 
-  g_mutex_lock (&listeners_mutex);
+  g_return_val_if_fail (listener != NULL, FALSE);
 
-  ret = gst_inter_pipe_leave_node_priv (listener);
-  if (!ret)
-    goto out;
+  listener_priv = gst_inter_pipe_lock_listener (listener, FALSE);
+  if (!listener_priv)
+    goto no_listener;
 
-  if (!gst_inter_pipe_leave_listeners_table (listener))
-    goto list_error;
+  ret = gst_inter_pipe_detach_locked (listener_priv);
+  if (ret)
+    gst_inter_pipe_leave_listeners_table (listener_priv);
+
+  gst_inter_pipe_unlock_listener (listener_priv);
 
-out:
-  g_mutex_unlock (&listeners_mutex);
   return ret;
 
-list_error:
+no_listener:
   {
-    GST_WARNING ("Could not leave node");
-    g_mutex_unlock (&listeners_mutex);
+    GST_WARNING ("Listener is not in the connected listeners list");
     return FALSE;
   }
 }
 
 static void
-gst_inter_pipe_notify_node_added (gpointer listener_name, gpointer _listener,
-    gpointer data)
+gst_inter_pipe_notify_node_added (gpointer _listener, gpointer data)
 {
-  GstInterPipeListenerPriv *listener_priv = _listener;
-  GstInterPipeIListener *listener = listener_priv->listener;
-  gchar *node_name = data;
+  GstInterPipeIListener *listener = _listener;
+  const gchar *node_name = data;
 
   GST_INFO ("Notifying new node added: %s", node_name);
 
   gst_inter_pipe_ilistener_node_added (listener, node_name);
+  g_object_unref (listener);
 }
 
 gboolean
 gst_inter_pipe_add_node (GstInterPipeINode * node, const gchar * node_name)
 {
-  GHashTable *nodes;
-  GHashTable *listeners;
+  GstInterPipeNodeEntry *entry;
+  GList *listeners;
 
   g_return_val_if_fail (node != NULL, FALSE);
   g_return_val_if_fail (node_name != NULL, FALSE);
 
-  g_mutex_lock (&nodes_mutex);
+  g_mutex_lock (&listeners_mutex);
+  g_rw_lock_writer_lock (&nodes_lock);
 
-  nodes = gst_inter_pipe_get_nodes ();
-  if (g_hash_table_contains (nodes, node_name))
+  entry = gst_inter_pipe_entry_get (node_name);
+  if (entry->node)
     goto no_unique;
 
   GST_INFO ("Adding node %s", node_name);
 
-  if (!g_hash_table_insert (nodes, (gchar *) node_name, (gpointer) node))
-    goto add_error;
-
-  g_mutex_unlock (&nodes_mutex);
+  entry->node = node;
+  g_weak_ref_set (&entry->node_ref, node);
+  g_hash_table_insert (gst_inter_pipe_get_node_entries (), node, entry);
 
-  listeners = gst_inter_pipe_get_listeners ();
-  g_hash_table_foreach (listeners, gst_inter_pipe_notify_node_added,
-      (gpointer) node_name);
+  g_rw_lock_writer_unlock (&nodes_lock);
 
+  /* Only wake up the listeners waiting for this node */
+  listeners = gst_inter_pipe_get_entry_listeners (entry, NULL);
+  g_mutex_unlock (&listeners_mutex);
 
+  g_list_foreach (listeners, gst_inter_pipe_notify_node_added,
+      (gpointer) node_name);
+  g_list_free (listeners);
 
   return TRUE;
 
 no_unique:
   {
     GST_WARNING ("Could not add node %s, it is not unique.", node_name);
-    g_mutex_unlock (&nodes_mutex);
-    return FALSE;
-  }
-add_error:
-  {
-    GST_INFO ("Could not add node %s", node_name);
-    g_mutex_unlock (&nodes_mutex);
+    g_rw_lock_writer_unlock (&nodes_lock);
+    g_mutex_unlock (&listeners_mutex);
     return FALSE;
   }
 }
 
 static void
-gst_inter_pipe_notify_node_removed (gpointer _listener_name, gpointer _listener,
-    gpointer data)
+gst_inter_pipe_notify_node_removed (gpointer _listener, gpointer data)
 {
-  gchar *node_name = data;
-  GstInterPipeListenerPriv *listener_priv = _listener;
-  GstInterPipeIListener *listener = listener_priv->listener;
+  const gchar *node_name = data;
+  GstInterPipeIListener *listener = _listener;
 
   GST_INFO ("Notifying node removed: %s", node_name);
 
   gst_inter_pipe_ilistener_node_removed (listener, node_name);
+  g_object_unref (listener);
+}
+
+/* The node is removed from its finalize too, so the listeners are
+ * detached here instead of trusting them to leave */
+static void
+gst_inter_pipe_detach_from_node (gpointer _listener, gpointer data)
+{
+  GstInterPipeIListener *listener = _listener;
+  GstInterPipeINode *node = data;
+  GstInterPipeListenerPriv *listener_priv;
+
+  listener_priv = gst_inter_pipe_lock_listener (listener, FALSE);
+  if (!listener_priv)
+    return;
+
+  if (listener_priv->node == node)
+    gst_inter_pipe_detach_locked (listener_priv);
+
+  gst_inter_pipe_unlock_listener (listener_priv);
 }
 
 gboolean
 gst_inter_pipe_remove_node (GstInterPipeINode * node, const gchar * node_name)
 {
-  GHashTable *nodes;
-  GHashTable *listeners;
+  GstInterPipeNodeEntry *entry;
+  GList *listeners;
 
   g_return_val_if_fail (node != NULL, FALSE);
   g_return_val_if_fail (node_name != NULL, FALSE);
 
-  g_mutex_lock (&nodes_mutex);
+  g_mutex_lock (&listeners_mutex);
+  g_rw_lock_writer_lock (&nodes_lock);
 
-  nodes = gst_inter_pipe_get_nodes ();
   GST_INFO ("Removing node %s", node_name);
-  if (!g_hash_table_remove (nodes, (gconstpointer) node_name)) {
-    GST_WARNING ("Node %s not found. Could not remove it.", node_name);
-    g_mutex_unlock (&nodes_mutex);
-    return FALSE;
-  }
-  g_mutex_unlock (&nodes_mutex);
+  entry = g_hash_table_lookup (gst_inter_pipe_get_entries (), node_name);
+  if (!entry || entry->node != node)
+    goto not_found;
 
-  listeners = gst_inter_pipe_get_listeners ();
-  g_hash_table_foreach (listeners, gst_inter_pipe_notify_node_removed,
+  entry->node = NULL;
+  g_weak_ref_set (&entry->node_ref, NULL);
+  g_hash_table_remove (gst_inter_pipe_get_node_entries (), node);
+
+  /* Only the listeners attached to this node need to leave it */
+  listeners = gst_inter_pipe_get_entry_listeners (entry, node);
+  gst_inter_pipe_entry_release (entry);
+
+  g_rw_lock_writer_unlock (&nodes_lock);
+  g_mutex_unlock (&listeners_mutex);
+
+  g_list_foreach (listeners, gst_inter_pipe_detach_from_node, node);
+  g_list_foreach (listeners, gst_inter_pipe_notify_node_removed,
       (gpointer) node_name);
+  g_list_free (listeners);
 
   return TRUE;
+
+not_found:
+  {
+    GST_WARNING ("Node %s not found. Could not remove it.", node_name);
+    g_rw_lock_writer_unlock (&nodes_lock);
+    g_mutex_unlock (&listeners_mutex);
+    return FALSE;
+  }
 }
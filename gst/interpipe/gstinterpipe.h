@@ -53,6 +53,63 @@ GstInterPipeINode * gst_inter_pipe_get_node (const gchar * node_name);
  */
 gboolean gst_inter_pipe_listen_node (GstInterPipeIListener * listener,
     const gchar * node_name);
+
+/**
+ * gst_inter_pipe_ref_node:
+ * @node_name: (transfer none)(not nullable): the name of the node to return
+ *
+ * Resolve @node_name once into a node handle that can be given to
+ * gst_inter_pipe_listen_inode() without further name lookups. The
+ * handle stays valid after the node is removed, but listening to it
+ * will fail from then on.
+ *
+ * Returns: (transfer full)(nullable): The respective GstInterPipeINode
+ * or null. Release it with g_object_unref().
+ */
+GstInterPipeINode * gst_inter_pipe_ref_node (const gchar * node_name);
+
+/**
+ * gst_inter_pipe_get_node_name:
+ * @node: (transfer none)(not nullable): The node handle to query
+ *
+ * Return the name @node is currently registered under.
+ *
+ * Returns: (transfer full)(nullable): The node name, or null if @node is
+ * not registered. Free it with g_free().
+ */
+gchar * gst_inter_pipe_get_node_name (GstInterPipeINode * node);
+
+/**
+ * gst_inter_pipe_listen_inode:
+ * @listener:(transfer none)(not nullable): The listener object to attach to the node
+ * @node:(transfer none)(not nullable): The node handle to attach to
+ *
+ * Same as gst_inter_pipe_listen_node() but takes a node handle
+ * obtained through gst_inter_pipe_ref_node(). Fails if @node is no
+ * longer registered.
+ *
+ * Returns: TRUE if the listener was registered correctly, FALSE otherwise.
+ */
+gboolean gst_inter_pipe_listen_inode (GstInterPipeIListener * listener,
+    GstInterPipeINode * node);
+
+/**
+ * gst_inter_pipe_listen_inodes:
+ * @listeners:(array length=num_listeners)(transfer none): The listeners to switch
+ * @nodes:(array length=num_listeners)(transfer none): The node handle for
+ * each listener, as obtained through gst_inter_pipe_ref_node()
+ * @num_listeners: The number of listeners and nodes
+ *
+ * Switch every listener in @listeners to the node at the same position
+ * in @nodes as a single update: no other switch of these listeners can
+ * interleave with it. A listener may only appear once. If any of the
+ * listeners fails to switch, the ones already switched are attached back
+ * to their previous nodes.
+ *
+ * Returns: TRUE if all the listeners were switched, FALSE if none was.
+ */
+gboolean gst_inter_pipe_listen_inodes (GstInterPipeIListener ** listeners,
+    GstInterPipeINode ** nodes, guint num_listeners);
 /**
  * gst_inter_pipe_leave_node:
  * @listener: (transfer none)(not nullable): The listener to detach
@@ -84,6 +84,33 @@ gst_inter_pipe_ilistener_push_buffer (GstInterPipeIListener * self,
   return iface->push_buffer (self, buffer, basetime);
 }
 
+gboolean
+gst_inter_pipe_ilistener_push_buffer_list (GstInterPipeIListener * self,
+    GstBufferList * list, guint64 basetime)
+{
+  GstInterPipeIListenerInterface *iface;
+  gboolean ret = TRUE;
+  guint i, len;
+
+  g_return_val_if_fail (GST_INTER_PIPE_IS_ILISTENER (self), FALSE);
+  g_return_val_if_fail (list, FALSE);
+
+  iface = GST_INTER_PIPE_ILISTENER_GET_IFACE (self);
+
+  if (iface->push_buffer_list)
+    return iface->push_buffer_list (self, list, basetime);
+
+  g_return_val_if_fail (iface->push_buffer != NULL, FALSE);
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret; i++)
+    ret = iface->push_buffer (self,
+        gst_buffer_ref (gst_buffer_list_get (list, i)), basetime);
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
 const gchar *
 gst_inter_pipe_ilistener_get_name (GstInterPipeIListener * self)
 {
@@ -154,3 +181,16 @@ gst_inter_pipe_ilistener_send_eos (GstInterPipeIListener * self)
 
   return iface->send_eos (self);
 }
+
+void
+gst_inter_pipe_ilistener_attached (GstInterPipeIListener * self,
+    struct _GstInterPipeINode *node)
+{
+  GstInterPipeIListenerInterface *iface;
+
+  g_return_if_fail (GST_INTER_PIPE_IS_ILISTENER (self));
+
+  iface = GST_INTER_PIPE_ILISTENER_GET_IFACE (self);
+  if (iface->attached)
+    iface->attached (self, node);
+}
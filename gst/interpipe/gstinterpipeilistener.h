@@ -39,6 +39,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstInterPipeIListener GstInterPipeIListener;    /* dummy object */
 typedef struct _GstInterPipeIListenerInterface GstInterPipeIListenerInterface;
+struct _GstInterPipeINode;
 
 /**
  * GstInterPipeIListenerInterface:
@@ -80,6 +81,10 @@ typedef struct _GstInterPipeIListenerInterface GstInterPipeIListenerInterface;
  *
  * @send_eos: Send an EOS event into the listener's pipeline. See
  * #gst_inter_pipe_ilistener_send_eos.
+ *
+ * @push_buffer_list: Push the given buffer list into the listener's
+ * pipeline in one go. Optional, lists are split into @push_buffer calls
+ * when not implemented. See #gst_inter_pipe_ilistener_push_buffer_list.
  */
 struct _GstInterPipeIListenerInterface
 {
@@ -95,6 +100,8 @@ struct _GstInterPipeIListenerInterface
   gboolean (* push_buffer) (GstInterPipeIListener *iface, GstBuffer *buffer, guint64 basetime);
   gboolean (* push_event) (GstInterPipeIListener *iface, GstEvent *event, guint64 basetime);
   gboolean (* send_eos) (GstInterPipeIListener *iface);
+  gboolean (* push_buffer_list) (GstInterPipeIListener *iface, GstBufferList *list, guint64 basetime);
+  void (* attached) (GstInterPipeIListener *iface, struct _GstInterPipeINode *node);
 };
 
 /**
@@ -177,6 +184,22 @@ gboolean gst_inter_pipe_ilistener_node_removed (GstInterPipeIListener *iface,
 gboolean gst_inter_pipe_ilistener_push_buffer (GstInterPipeIListener *iface,
     GstBuffer *buffer, guint64 basetime);
 
+/**
+ * gst_inter_pipe_ilistener_push_buffer_list:
+ * @iface: (transfer none)(not nullable): The object that should push the #GstBufferList downstream.
+ * @list: (transfer full)(not nullable): The #GstBufferList to be pushed downstream.
+ * @basetime: The basetime of the node's pipeline, see
+ * #gst_inter_pipe_ilistener_push_buffer.
+ *
+ * Push all the buffers in @list to the downstream element. Listeners that
+ * don't implement it get the buffers one by one through
+ * #gst_inter_pipe_ilistener_push_buffer.
+ *
+ * Return: True if the buffers were successfully pushed, False otherwise.
+ */
+gboolean gst_inter_pipe_ilistener_push_buffer_list (GstInterPipeIListener *iface,
+    GstBufferList *list, guint64 basetime);
+
 /**
  * gst_inter_pipe_ilistener_push_event:
  * @iface: (transfer none)(not nullable): The object that should push the #GstEvent downstream.
@@ -203,6 +226,19 @@ gboolean gst_inter_pipe_ilistener_push_event (GstInterPipeIListener *iface,
  */
 gboolean gst_inter_pipe_ilistener_send_eos (GstInterPipeIListener *iface);
 
+/**
+ * gst_inter_pipe_ilistener_attached:
+ * @iface: (transfer none)(not nullable): The listener that was attached or detached.
+ * @node: (transfer none)(nullable): The #GstInterPipeINode the listener is attached to,
+ * NULL once it is detached.
+ *
+ * Called by the core whenever the node a listener is attached to changes, so
+ * the listener can reach its node without looking it up by name. The calls
+ * of a listener are serialized, @node is alive for the duration of the call.
+ */
+void gst_inter_pipe_ilistener_attached (GstInterPipeIListener *iface,
+    struct _GstInterPipeINode *node);
+
 GType gst_inter_pipe_ilistener_get_type (void);
 
 G_END_DECLS
@@ -79,3 +79,18 @@ gst_inter_pipe_inode_receive_event (GstInterPipeINode * self, GstEvent * event)
 
   return iface->receive_event (self, event);
 }
+
+gboolean
+gst_inter_pipe_inode_rejoin_listener (GstInterPipeINode * self,
+    GstInterPipeIListener * listener)
+{
+  GstInterPipeINodeInterface *iface;
+
+  g_return_val_if_fail (GST_INTER_PIPE_IS_INODE (self), FALSE);
+
+  iface = GST_INTER_PIPE_INODE_GET_IFACE (self);
+  if (!iface->rejoin_listener)
+    return gst_inter_pipe_inode_add_listener (self, listener);
+
+  return iface->rejoin_listener (self, listener);
+}
@@ -57,6 +57,10 @@ typedef struct _GstInterPipeINodeInterface GstInterPipeINodeInterface;
  * @event and forward it upstream. It is responsability of the node to
  * decide if the event can be forwarded or not. See
  * #gst_inter_pipe_inode_receive_event.
+ *
+ * @rejoin_listener: Optional. Store @listener again after it was
+ * removed by a switch that failed. See
+ * #gst_inter_pipe_inode_rejoin_listener.
  */
 struct _GstInterPipeINodeInterface
 {
@@ -65,6 +69,7 @@ struct _GstInterPipeINodeInterface
   gboolean (* add_listener) (GstInterPipeINode *iface, GstInterPipeIListener * listener);
   gboolean (* remove_listener) (GstInterPipeINode *iface, GstInterPipeIListener * listener);
   gboolean (* receive_event) (GstInterPipeINode *iface, GstEvent *event);
+  gboolean (* rejoin_listener) (GstInterPipeINode *iface, GstInterPipeIListener * listener);
 };
 
 /**
@@ -83,7 +88,8 @@ gboolean gst_inter_pipe_inode_add_listener (GstInterPipeINode *iface, GstInterPi
  * @iface: (transfer none)(not nullable): The object implementing the interface.
  * @listener: (transfer none)(not nullable): The listener to be removed from the internal list.
  *
- * Look for @listener in the internal storage and remove it.
+ * Look for @listener in the internal storage and remove it. Once it
+ * returns the node pushes nothing else into @listener.
  *
  * Returns: True if the listener was found and successfully removed, False otherwise.
  */
@@ -104,6 +110,20 @@ gboolean gst_inter_pipe_inode_remove_listener (GstInterPipeINode *iface, GstInte
  */
 gboolean gst_inter_pipe_inode_receive_event (GstInterPipeINode *iface, GstEvent *event);
 
+/**
+ * gst_inter_pipe_inode_rejoin_listener:
+ * @iface: (transfer none)(not nullable): The object implementing the interface.
+ * @listener: (transfer none)(not nullable): The listener to be stored again.
+ *
+ * Store @listener again after a failed switch removed it. Unlike
+ * gst_inter_pipe_inode_add_listener() the listener is already set up
+ * for this node, so nothing is replayed to it. Nodes that don't
+ * implement it add the listener again.
+ *
+ * Returns: True if the listener was successfully stored, False otherwise.
+ */
+gboolean gst_inter_pipe_inode_rejoin_listener (GstInterPipeINode *iface, GstInterPipeIListener * listener);
+
 GType gst_inter_pipe_inode_get_type (void);
 
 G_END_DECLS
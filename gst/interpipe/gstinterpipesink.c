@@ -36,6 +36,50 @@
  *   interpipesrc listen-to=test ! xvimagesink
  * ]| Send buffers across two different pipelines
  * </refsect2>
+ *
+ * By default buffers are delivered to every listener from the streaming
+ * thread of the node, so a listener that blocks stalls the rest of them.
+ * Setting any of #GstInterPipeSink:listener-queue-size,
+ * #GstInterPipeSink:listener-queue-max-bytes or
+ * #GstInterPipeSink:listener-queue-max-time gives each listener its own
+ * bounded queue and delivery thread instead, and
+ * #GstInterPipeSink:listener-queue-leaky selects what happens when one of
+ * those queues is full. With #GstInterPipeSink:shared-delivery the queues
+ * are drained by a pool of workers shared by all the nodes, one per core,
+ * instead of a thread per listener. Setting the
+ * GST_INTERPIPE_PIN_DELIVERY_WORKERS environment variable pins each of
+ * those workers to its own core.
+ *
+ * A shared worker keeps its thread while a listener blocks it, for
+ * instance an interpipesrc with block=true and a stalled downstream.
+ * Once as many listeners as there are cores block, the other shared
+ * queues wait until one of them returns, their own queue limits still
+ * protect the streaming thread meanwhile. Nodes whose listeners may
+ * block for long should keep a thread per listener instead.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch \
+ *   videotestsrc ! interpipesink name=test listener-queue-size=5 \
+ *   interpipesrc listen-to=test ! xvimagesink
+ * ]| Deliver buffers to each listener from its own thread
+ * </refsect2>
+ *
+ * With #GstInterPipeSink:gop-cache enabled the node keeps the stream
+ * headers and the buffers since the last keyframe, and replays them to
+ * every listener that joins, so it can start decoding without waiting
+ * for the next keyframe. The replayed buffers keep their original
+ * timestamps, synchronized sinks downstream will drop them as late once
+ * they have been decoded.
+ *
+ * A node without listeners discards every buffer it receives. With
+ * #GstInterPipeSink:block-without-listeners the streaming thread is
+ * blocked instead while the node is PLAYING and nobody listens, so an
+ * expensive producer branch idles until a listener attaches. An element
+ * message named "GstInterPipeSinkIdle", with a boolean "idle" field, is
+ * posted whenever the node starts or stops blocking, applications may use
+ * it to pause live producers that can't be blocked.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -46,6 +90,7 @@
 
 #include "gstinterpipesink.h"
 #include "gstinterpipeinode.h"
+#include "gstinterpipetaskpool.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_inter_pipe_sink_debug);
 #define GST_CAT_DEFAULT gst_inter_pipe_sink_debug
@@ -55,9 +100,55 @@ enum
   PROP_0,
   PROP_FORWARD_EOS,
   PROP_FORWARD_EVENTS,
-  PROP_NUM_LISTENERS
+  PROP_NUM_LISTENERS,
+  PROP_LISTENER_QUEUE_SIZE,
+  PROP_LISTENER_QUEUE_LEAKY,
+  PROP_LISTENER_QUEUE_MAX_BYTES,
+  PROP_LISTENER_QUEUE_MAX_TIME,
+  PROP_GOP_CACHE,
+  PROP_GOP_CACHE_MAX_BYTES,
+  PROP_GOP_CACHE_MAX_TIME,
+  PROP_SHARED_DELIVERY,
+  PROP_BLOCK_WITHOUT_LISTENERS
 };
 
+#define DEFAULT_GOP_CACHE_MAX_BYTES (16 * 1024 * 1024)
+#define DEFAULT_GOP_CACHE_MAX_TIME (10 * GST_SECOND)
+
+/* Items a shared worker delivers before giving the other queues a turn */
+#define SHARED_DELIVERY_BATCH 16
+
+typedef enum
+{
+  GST_INTER_PIPE_SINK_LEAKY_NO,
+  GST_INTER_PIPE_SINK_LEAKY_UPSTREAM,
+  GST_INTER_PIPE_SINK_LEAKY_DOWNSTREAM
+} GstInterPipeSinkLeaky;
+
+#define GST_TYPE_INTER_PIPE_SINK_LEAKY (gst_inter_pipe_sink_leaky_get_type ())
+static GType
+gst_inter_pipe_sink_leaky_get_type (void)
+{
+  static GType inter_pipe_sink_leaky_type = 0;
+  static const GEnumValue leaky_types[] = {
+    {GST_INTER_PIPE_SINK_LEAKY_NO, "Not Leaky, block the node", "no"},
+    {GST_INTER_PIPE_SINK_LEAKY_UPSTREAM, "Leaky on upstream (new buffers)",
+        "upstream"},
+    {GST_INTER_PIPE_SINK_LEAKY_DOWNSTREAM,
+        "Leaky on downstream (old buffers)", "downstream"},
+    {0, NULL, NULL}
+  };
+  if (!inter_pipe_sink_leaky_type) {
+    inter_pipe_sink_leaky_type =
+        g_enum_register_static ("GstInterPipeSinkLeaky", leaky_types);
+  }
+  return inter_pipe_sink_leaky_type;
+}
+
+typedef struct _GstInterPipeSinkQueue GstInterPipeSinkQueue;
+typedef struct _GstInterPipeSinkTarget GstInterPipeSinkTarget;
+typedef struct _GstInterPipeSinkListeners GstInterPipeSinkListeners;
+
 static void gst_inter_pipe_sink_update_node_name (GstInterPipeSink * sink,
     GParamSpec * pspec);
 static void gst_inter_pipe_sink_set_property (GObject * object, guint prop_id,
@@ -65,10 +156,10 @@ static void gst_inter_pipe_sink_set_property (GObject * object, guint prop_id,
 static void gst_inter_pipe_sink_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void gst_inter_pipe_sink_finalize (GObject * object);
-static GstFlowReturn gst_inter_pipe_sink_new_buffer (GstAppSink * sink,
-    gpointer data);
-static GstFlowReturn gst_inter_pipe_sink_new_preroll (GstAppSink * asink,
-    gpointer data);
+static GstFlowReturn gst_inter_pipe_sink_render (GstBaseSink * base,
+    GstBuffer * buffer);
+static GstFlowReturn gst_inter_pipe_sink_render_list (GstBaseSink * base,
+    GstBufferList * list);
 static void gst_inter_pipe_sink_eos (GstAppSink * sink, gpointer data);
 static gboolean gst_inter_pipe_sink_add_listener (GstInterPipeINode * iface,
     GstInterPipeIListener * listener);
@@ -76,6 +167,8 @@ static gboolean gst_inter_pipe_sink_remove_listener (GstInterPipeINode * iface,
     GstInterPipeIListener * listener);
 static gboolean gst_inter_pipe_sink_receive_event (GstInterPipeINode * iface,
     GstEvent * event);
+static gboolean gst_inter_pipe_sink_rejoin_listener (GstInterPipeINode * iface,
+    GstInterPipeIListener * listener);
 static GstCaps *gst_inter_pipe_sink_get_caps (GstBaseSink * base,
     GstCaps * filter);
 static gboolean gst_inter_pipe_sink_set_caps (GstBaseSink * base,
@@ -88,21 +181,77 @@ static GstCaps *gst_inter_pipe_sink_caps_intersect (GstCaps * caps1,
     GstCaps * caps2);
 static void gst_inter_pipe_sink_intersect_listener_caps (gpointer key,
     gpointer value, gpointer user_data);
-static void gst_inter_pipe_sink_forward_event (gpointer key, gpointer value,
-    gpointer user_data);
+static void gst_inter_pipe_sink_forward_event (GstInterPipeSink * sink,
+    GstInterPipeSinkTarget * target, GstEvent * event);
+static GstInterPipeSinkListeners
+    * gst_inter_pipe_sink_listeners_new (GstInterPipeSink * sink);
+static GstInterPipeSinkListeners
+    * gst_inter_pipe_sink_listeners_ref (GstInterPipeSinkListeners * listeners);
+static void gst_inter_pipe_sink_listeners_unref (GstInterPipeSinkListeners *
+    listeners);
+static GstInterPipeSinkListeners
+    * gst_inter_pipe_sink_get_listeners (GstInterPipeSink * sink);
+static void gst_inter_pipe_sink_publish_listeners (GstInterPipeSink * sink);
+static GstInterPipeSinkTarget *gst_inter_pipe_sink_target_new (GstInterPipeSink
+    * sink, GstInterPipeIListener * listener);
+static GstInterPipeSinkTarget
+    * gst_inter_pipe_sink_target_ref (GstInterPipeSinkTarget * target);
+static void gst_inter_pipe_sink_target_unref (GstInterPipeSinkTarget * target);
+static gboolean gst_inter_pipe_sink_target_enter (GstInterPipeSinkTarget *
+    target, gpointer * outer);
+static void gst_inter_pipe_sink_target_leave (GstInterPipeSinkTarget * target,
+    gpointer outer);
+static void gst_inter_pipe_sink_target_stop (GstInterPipeSinkTarget * target);
+static gboolean gst_inter_pipe_sink_target_hold (GstInterPipeSinkTarget *
+    target, GstMiniObject * item);
+static void gst_inter_pipe_sink_target_dispatch (GstInterPipeSink * sink,
+    GstInterPipeSinkTarget * target, GstMiniObject * item);
+static void gst_inter_pipe_sink_target_replay (GstInterPipeSink * sink,
+    GstInterPipeSinkTarget * target, GQueue * replay);
+static GstClockTime gst_inter_pipe_sink_get_base_time (GstInterPipeSink *
+    sink);
+static void gst_inter_pipe_sink_deliver (GstInterPipeSink * sink,
+    GstInterPipeIListener * listener, GstMiniObject * item);
+static GstInterPipeSinkQueue *gst_inter_pipe_sink_queue_new (GstInterPipeSink *
+    sink, GstInterPipeIListener * listener);
+static GstInterPipeSinkQueue
+    * gst_inter_pipe_sink_queue_ref (GstInterPipeSinkQueue * queue);
+static void gst_inter_pipe_sink_queue_unref (GstInterPipeSinkQueue * queue);
+static void gst_inter_pipe_sink_queue_close (GstInterPipeSinkQueue * queue);
+static void gst_inter_pipe_sink_queue_stop (GstInterPipeSinkQueue * queue);
+static void gst_inter_pipe_sink_queue_push (GstInterPipeSinkQueue * queue,
+    GstMiniObject * item);
+static void gst_inter_pipe_sink_queue_flush (GstInterPipeSinkQueue * queue);
+static void gst_inter_pipe_sink_queue_schedule (GstInterPipeSinkQueue *
+    queue);
+static void gst_inter_pipe_sink_cache_reset (GstInterPipeSink * sink);
+static void gst_inter_pipe_sink_cache_buffer (GstInterPipeSink * sink,
+    GstBuffer * buffer);
+static void gst_inter_pipe_sink_cache_snapshot (GstInterPipeSink * sink,
+    GQueue * replay);
+static gboolean gst_inter_pipe_sink_snapshot_sticky_event (GstPad * pad,
+    GstEvent ** event, gpointer user_data);
+static GstStateChangeReturn gst_inter_pipe_sink_change_state (GstElement *
+    element, GstStateChange transition);
+static GstMessage *gst_inter_pipe_sink_update_idle (GstInterPipeSink * sink);
+static void gst_inter_pipe_sink_set_playing (GstInterPipeSink * sink,
+    gboolean playing);
 
 static void gst_inter_pipe_inode_init (GstInterPipeINodeInterface * iface);
 
 #define GST_INTER_PIPE_SINK_PAD(obj)                 (GST_BASE_SINK_CAST (obj)->sinkpad)
 
+/* Buffer lists take a single slot in the listener queues */
+#define GST_INTER_PIPE_SINK_IS_DATA(obj) \
+  (GST_IS_BUFFER (obj) || GST_IS_BUFFER_LIST (obj))
+
 struct _GstInterPipeSink
 {
   GstAppSink parent;
 
   /** Node name */
   gchar *node_name;
-
-  /** The list of listeners */
+  /** The list of listeners, indexed by the listener itself */
   GHashTable *listeners;
 
   /** Enable Events notify */
@@ -120,7 +269,120 @@ struct _GstInterPipeSink
   /** Last buffer timestamp */
   guint64 last_buffer_timestamp;
 
+  /** Per listener delivery queue limits, 0 means unlimited. With all
+   * of them unlimited and no shared delivery the streaming thread
+   * delivers directly */
+  guint listener_queue_size;
+  guint listener_queue_max_bytes;
+  GstClockTime listener_queue_max_time;
+
+  /** What to drop when a listener queue is full */
+  GstInterPipeSinkLeaky listener_queue_leaky;
+
+  /** Drain the listener queues from the shared delivery workers */
+  gboolean shared_delivery;
+
+  /** Delivery targets indexed by their listener */
+  GHashTable *targets;
+
+  /** Immutable copy of the targets used by the data flow, swapped
+   * atomically. snapshot_readers counts the threads taking a reference */
+  GstInterPipeSinkListeners *snapshot;
+  gint snapshot_readers;
+
   GMutex listeners_mutex;
+
+  /** Block the streaming thread while PLAYING without listeners. The
+   * probe doing it is installed while idle_probe is set, all of them
+   * are protected by listeners_mutex */
+  gboolean block_without_listeners;
+  gboolean playing;
+  gulong idle_probe;
+
+  /** Replay the current GOP to new listeners */
+  gboolean gop_cache;
+  guint gop_cache_max_bytes;
+  GstClockTime gop_cache_max_time;
+
+  /** Stream headers and buffers since the last keyframe */
+  GQueue cache_headers;
+  GQueue cache;
+  gsize cache_bytes;
+  gboolean cache_last_header;
+
+  /** Keeps new listeners and the streaming thread in order */
+  GMutex cache_mutex;
+};
+
+struct _GstInterPipeSinkTarget
+{
+  gint refcount;
+
+  GstInterPipeIListener *listener;
+
+  /* NULL when buffers are pushed from the streaming thread */
+  GstInterPipeSinkQueue *queue;
+
+  /* Cleared when the listener is removed. in_flight counts the pushes
+   * still running from older snapshots, the removal waits for them on
+   * drain_cond */
+  gint active;
+  gint in_flight;
+  GMutex drain_mutex;
+  GCond drain_cond;
+
+  /* Set while a new listener is brought up to date outside the locks,
+   * the live items pushed meanwhile wait in held so they can't overtake
+   * the replay. Protected by replay_mutex */
+  gint replaying;
+  GQueue held;
+  GMutex replay_mutex;
+};
+
+/* The listeners table is only modified under listeners_mutex, every
+ * change publishes a new snapshot that the streaming thread can iterate
+ * without holding any lock while pushing into the listeners */
+struct _GstInterPipeSinkListeners
+{
+  gint refcount;
+
+  guint num_targets;
+  GstInterPipeSinkTarget **targets;
+};
+
+struct _GstInterPipeSinkQueue
+{
+  gint refcount;
+
+  GstInterPipeSink *sink;
+  GstInterPipeIListener *listener;
+
+  /* Buffers and serialized events waiting to be delivered */
+  GQueue items;
+  guint num_buffers;
+  guint num_bytes;
+  /* Timestamp of the newest buffer in the queue */
+  GstClockTime last_ts;
+
+  /* Limits, 0 means unlimited */
+  guint max_buffers;
+  guint max_bytes;
+  GstClockTime max_time;
+
+  /* Buffers dropped because the queue was full */
+  guint64 dropped;
+
+  gboolean flushing;
+  GThread *thread;
+
+  /* Drained by the shared workers instead of its own thread. A job is
+   * pushed to the pool while scheduled, worker is the thread running it */
+  gboolean shared;
+  gboolean scheduled;
+  GThread *worker;
+
+  GMutex mutex;
+  GCond cond;
 };
 
 struct _GstInterPipeSinkClass
@@ -156,6 +418,9 @@ gst_inter_pipe_sink_class_init (GstInterPipeSinkClass * klass)
   gobject_class->get_property = gst_inter_pipe_sink_get_property;
   gobject_class->finalize = gst_inter_pipe_sink_finalize;
 
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_change_state);
+
   g_object_class_install_property (gobject_class, PROP_FORWARD_EOS,
       g_param_spec_boolean ("forward-eos", "Forward EOS",
           "Forward the EOS event to all the listeners",
@@ -171,9 +436,87 @@ gst_inter_pipe_sink_class_init (GstInterPipeSinkClass * klass)
           "Number of interpipe sources listening to this specific sink",
           0, G_MAXUINT, 0, G_PARAM_READABLE));
 
+  g_object_class_install_property (gobject_class, PROP_LISTENER_QUEUE_SIZE,
+      g_param_spec_uint ("listener-queue-size", "Listener queue size",
+          "Maximum number of buffers queued for each listener, delivered "
+          "from a dedicated thread per listener, or from the shared workers "
+          "with shared-delivery. 0 means unlimited, when all the listener "
+          "queue limits are 0 and shared-delivery is off the buffers are "
+          "pushed to the listeners from the streaming thread. Applies to "
+          "listeners added after the change", 0, G_MAXUINT, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_LISTENER_QUEUE_MAX_BYTES,
+      g_param_spec_uint ("listener-queue-max-bytes",
+          "Listener queue max bytes",
+          "Maximum number of bytes queued for each listener (0 = unlimited). "
+          "Applies to listeners added after the change", 0, G_MAXUINT, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_LISTENER_QUEUE_MAX_TIME,
+      g_param_spec_uint64 ("listener-queue-max-time",
+          "Listener queue max time",
+          "Maximum amount of time in ns queued for each listener, measured "
+          "on the buffer timestamps (0 = unlimited). Applies to listeners "
+          "added after the change", 0, G_MAXUINT64, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LISTENER_QUEUE_LEAKY,
+      g_param_spec_enum ("listener-queue-leaky", "Listener queue leaky",
+          "Where to drop buffers when the queue of a listener is full",
+          GST_TYPE_INTER_PIPE_SINK_LEAKY, GST_INTER_PIPE_SINK_LEAKY_DOWNSTREAM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GOP_CACHE,
+      g_param_spec_boolean ("gop-cache", "GOP cache",
+          "Keep the stream headers and the buffers since the last keyframe "
+          "and replay them to new listeners so they can start decoding "
+          "right away", FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GOP_CACHE_MAX_BYTES,
+      g_param_spec_uint ("gop-cache-max-bytes", "GOP cache max bytes",
+          "Drop the cached GOP when it grows beyond this size, until the "
+          "next keyframe (0 = unlimited)", 0, G_MAXUINT,
+          DEFAULT_GOP_CACHE_MAX_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GOP_CACHE_MAX_TIME,
+      g_param_spec_uint64 ("gop-cache-max-time", "GOP cache max time",
+          "Drop the cached GOP when it spans more than this time in ns, "
+          "until the next keyframe (0 = unlimited)", 0, G_MAXUINT64,
+          DEFAULT_GOP_CACHE_MAX_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SHARED_DELIVERY,
+      g_param_spec_boolean ("shared-delivery", "Shared delivery",
+          "Queue the buffers for every listener and deliver them from "
+          "workers shared by all the interpipesinks, one per core, so the "
+          "streaming thread returns right away and large fan-outs run in "
+          "parallel. A blocked listener keeps its worker, the other queues "
+          "stall once every worker is blocked. The listener queue limits "
+          "still apply. Applies to listeners added after the change", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_BLOCK_WITHOUT_LISTENERS,
+      g_param_spec_boolean ("block-without-listeners",
+          "Block without listeners",
+          "Block the streaming thread while PLAYING and no listener is "
+          "attached instead of discarding the buffers, so the upstream "
+          "branch idles until a listener shows up", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   basesink_class->get_caps = GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_get_caps);
   basesink_class->set_caps = GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_set_caps);
   basesink_class->event = GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_event);
+  /* Forward buffers from the streaming thread instead of queueing them
+   * as samples in appsink and pulling them back out */
+  basesink_class->preroll = GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_render);
+  basesink_class->render = GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_render);
+  basesink_class->render_list =
+      GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_render_list);
 
 }
 
@@ -206,8 +549,28 @@ gst_inter_pipe_sink_init (GstInterPipeSink * sink)
   sink->forward_eos = FALSE;
   sink->forward_events = TRUE;
   sink->last_buffer_timestamp = 0;
+  sink->listener_queue_size = 0;
+  sink->listener_queue_max_bytes = 0;
+  sink->listener_queue_max_time = 0;
+  sink->listener_queue_leaky = GST_INTER_PIPE_SINK_LEAKY_DOWNSTREAM;
+  sink->shared_delivery = FALSE;
+  sink->block_without_listeners = FALSE;
+  sink->playing = FALSE;
+  sink->idle_probe = 0;
+  sink->targets = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) gst_inter_pipe_sink_target_stop);
+  sink->snapshot = gst_inter_pipe_sink_listeners_new (sink);
+  sink->snapshot_readers = 0;
+  sink->gop_cache = FALSE;
+  sink->gop_cache_max_bytes = DEFAULT_GOP_CACHE_MAX_BYTES;
+  sink->gop_cache_max_time = DEFAULT_GOP_CACHE_MAX_TIME;
+  g_queue_init (&sink->cache_headers);
+  g_queue_init (&sink->cache);
+  sink->cache_bytes = 0;
+  sink->cache_last_header = FALSE;
 
   g_mutex_init (&sink->listeners_mutex);
+  g_mutex_init (&sink->cache_mutex);
 
   /* Set the struct buffer to 0's so if in the future more callbacks are added
    * does not cause a segmentation fault down the line
@@ -216,14 +579,10 @@ gst_inter_pipe_sink_init (GstInterPipeSink * sink)
 
   /* AppSink callbacks */
   callbacks.eos = GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_eos);
-  callbacks.new_sample = GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_new_buffer);
-  callbacks.new_preroll = GST_DEBUG_FUNCPTR (gst_inter_pipe_sink_new_preroll);
   gst_app_sink_set_callbacks (GST_APP_SINK (sink), &callbacks, NULL, NULL);
 
   /*AppSink configuration */
-  gst_app_sink_set_drop (GST_APP_SINK (sink), TRUE);
   gst_base_sink_set_sync (GST_BASE_SINK (sink), FALSE);
-  gst_app_sink_set_max_buffers (GST_APP_SINK (sink), 3);
 
   /* When a change in the interpipesink name happens, the callback function
      will update the node name and the nodes list */
@@ -239,6 +598,7 @@ gst_inter_pipe_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
   GstInterPipeSink *sink;
+  GstMessage *message;
 
   g_return_if_fail (GST_IS_INTER_PIPE_SINK (object));
 
@@ -251,6 +611,42 @@ gst_inter_pipe_sink_set_property (GObject * object, guint prop_id,
     case PROP_FORWARD_EVENTS:
       sink->forward_events = g_value_get_boolean (value);
       break;
+    case PROP_LISTENER_QUEUE_SIZE:
+      sink->listener_queue_size = g_value_get_uint (value);
+      break;
+    case PROP_LISTENER_QUEUE_LEAKY:
+      sink->listener_queue_leaky = g_value_get_enum (value);
+      break;
+    case PROP_LISTENER_QUEUE_MAX_BYTES:
+      sink->listener_queue_max_bytes = g_value_get_uint (value);
+      break;
+    case PROP_LISTENER_QUEUE_MAX_TIME:
+      sink->listener_queue_max_time = g_value_get_uint64 (value);
+      break;
+    case PROP_GOP_CACHE:
+      g_mutex_lock (&sink->cache_mutex);
+      sink->gop_cache = g_value_get_boolean (value);
+      if (!sink->gop_cache)
+        gst_inter_pipe_sink_cache_reset (sink);
+      g_mutex_unlock (&sink->cache_mutex);
+      break;
+    case PROP_GOP_CACHE_MAX_BYTES:
+      sink->gop_cache_max_bytes = g_value_get_uint (value);
+      break;
+    case PROP_GOP_CACHE_MAX_TIME:
+      sink->gop_cache_max_time = g_value_get_uint64 (value);
+      break;
+    case PROP_SHARED_DELIVERY:
+      sink->shared_delivery = g_value_get_boolean (value);
+      break;
+    case PROP_BLOCK_WITHOUT_LISTENERS:
+      g_mutex_lock (&sink->listeners_mutex);
+      sink->block_without_listeners = g_value_get_boolean (value);
+      message = gst_inter_pipe_sink_update_idle (sink);
+      g_mutex_unlock (&sink->listeners_mutex);
+      if (message)
+        gst_element_post_message (GST_ELEMENT (sink), message);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -275,6 +671,33 @@ gst_inter_pipe_sink_get_property (GObject * object, guint prop_id,
       g_value_set_uint (value, g_hash_table_size (listeners));
       g_mutex_unlock (&sink->listeners_mutex);
       break;
+    case PROP_LISTENER_QUEUE_SIZE:
+      g_value_set_uint (value, sink->listener_queue_size);
+      break;
+    case PROP_LISTENER_QUEUE_LEAKY:
+      g_value_set_enum (value, sink->listener_queue_leaky);
+      break;
+    case PROP_LISTENER_QUEUE_MAX_BYTES:
+      g_value_set_uint (value, sink->listener_queue_max_bytes);
+      break;
+    case PROP_LISTENER_QUEUE_MAX_TIME:
+      g_value_set_uint64 (value, sink->listener_queue_max_time);
+      break;
+    case PROP_GOP_CACHE:
+      g_value_set_boolean (value, sink->gop_cache);
+      break;
+    case PROP_GOP_CACHE_MAX_BYTES:
+      g_value_set_uint (value, sink->gop_cache_max_bytes);
+      break;
+    case PROP_GOP_CACHE_MAX_TIME:
+      g_value_set_uint64 (value, sink->gop_cache_max_time);
+      break;
+    case PROP_SHARED_DELIVERY:
+      g_value_set_boolean (value, sink->shared_delivery);
+      break;
+    case PROP_BLOCK_WITHOUT_LISTENERS:
+      g_value_set_boolean (value, sink->block_without_listeners);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -305,21 +728,108 @@ gst_inter_pipe_sink_finalize (GObject * object)
     gst_caps_unref (sink->caps_negotiated);
   }
 
+  gst_inter_pipe_sink_listeners_unref (sink->snapshot);
+  g_hash_table_destroy (sink->targets);
   g_hash_table_destroy (sink->listeners);
 
+  gst_inter_pipe_sink_cache_reset (sink);
+
   g_mutex_clear (&sink->listeners_mutex);
+  g_mutex_clear (&sink->cache_mutex);
 
   /* Chain up to the parent class */
   G_OBJECT_CLASS (gst_inter_pipe_sink_parent_class)->finalize (object);
 }
 
+static GstStateChangeReturn
+gst_inter_pipe_sink_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstInterPipeSink *sink;
+  GstStateChangeReturn ret;
+
+  sink = GST_INTER_PIPE_SINK (element);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      /* Let a buffer through so the sink can preroll again */
+      gst_inter_pipe_sink_set_playing (sink, FALSE);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (gst_inter_pipe_sink_parent_class)->change_state
+      (element, transition);
+
+  if (GST_STATE_CHANGE_PAUSED_TO_PLAYING == transition
+      && GST_STATE_CHANGE_FAILURE != ret)
+    gst_inter_pipe_sink_set_playing (sink, TRUE);
+
+  return ret;
+}
+
+/* Idling without listeners */
+static GstPadProbeReturn
+gst_inter_pipe_sink_idle_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  /* Keep the data blocked until the probe is removed */
+  return GST_PAD_PROBE_OK;
+}
+
+/* Must be called with listeners_mutex held. Returns the message to post
+ * once the mutex is released, NULL if nothing changed */
+static GstMessage *
+gst_inter_pipe_sink_update_idle (GstInterPipeSink * sink)
+{
+  GstPad *pad;
+  gboolean idle;
+
+  pad = GST_INTER_PIPE_SINK_PAD (sink);
+  idle = sink->block_without_listeners && sink->playing
+      && 0 == g_hash_table_size (sink->listeners);
+
+  if (idle == (0 != sink->idle_probe))
+    return NULL;
+
+  if (idle) {
+    GST_INFO_OBJECT (sink, "No listeners, blocking upstream");
+    sink->idle_probe = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BLOCK |
+        GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+        gst_inter_pipe_sink_idle_probe, NULL, NULL);
+  } else {
+    GST_INFO_OBJECT (sink, "Unblocking upstream");
+    gst_pad_remove_probe (pad, sink->idle_probe);
+    sink->idle_probe = 0;
+  }
+
+  return gst_message_new_element (GST_OBJECT (sink),
+      gst_structure_new ("GstInterPipeSinkIdle", "idle", G_TYPE_BOOLEAN, idle,
+          NULL));
+}
+
+static void
+gst_inter_pipe_sink_set_playing (GstInterPipeSink * sink, gboolean playing)
+{
+  GstMessage *message;
+
+  g_mutex_lock (&sink->listeners_mutex);
+  sink->playing = playing;
+  message = gst_inter_pipe_sink_update_idle (sink);
+  g_mutex_unlock (&sink->listeners_mutex);
+
+  if (message)
+    gst_element_post_message (GST_ELEMENT (sink), message);
+}
+
 static void
 gst_inter_pipe_sink_update_listener_caps (gpointer key, gpointer data,
     gpointer user_data)
 {
   GstInterPipeIListener *listener;
   GstAppSink *appsink;
-  gchar *listener_name;
+  const gchar *listener_name;
   GstCaps *caps;
   gpointer *data_array = user_data;
 
@@ -327,7 +837,7 @@ gst_inter_pipe_sink_update_listener_caps (gpointer key, gpointer data,
   caps = GST_CAPS (data_array[1]);
 
   listener = GST_INTER_PIPE_ILISTENER (data);
-  listener_name = (gchar *) key;
+  listener_name = gst_inter_pipe_ilistener_get_name (listener);
 
   GST_LOG_OBJECT (appsink, "Setting caps %" GST_PTR_FORMAT " to %s",
       caps, listener_name);
@@ -535,19 +1045,14 @@ gst_inter_pipe_sink_set_caps (GstBaseSink * base, GstCaps * caps)
 }
 
 static void
-gst_inter_pipe_sink_forward_event (gpointer key, gpointer data,
-    gpointer user_data)
+gst_inter_pipe_sink_forward_event (GstInterPipeSink * sink,
+    GstInterPipeSinkTarget * target, GstEvent * event)
 {
-  GstInterPipeIListener *listener;
-  GstInterPipeSink *sink;
-  GstEvent *event;
-  guint64 basetime;
-  gpointer *data_array;
+  GstMiniObject *item;
+  gpointer outer;
 
-  listener = GST_INTER_PIPE_ILISTENER (data);
-  data_array = user_data;
-  sink = GST_INTER_PIPE_SINK (data_array[0]);
-  event = GST_EVENT (data_array[1]);
+  if (!gst_inter_pipe_sink_target_enter (target, &outer))
+    return;
 
   if (GST_EVENT_IS_SERIALIZED (event)) {
     GST_INFO_OBJECT (sink, "Incoming serialized event %s",
@@ -568,152 +1073,1010 @@ gst_inter_pipe_sink_forward_event (gpointer key, gpointer data,
       /*We manage the event with other functions */
       break;
     default:
-      basetime = gst_element_get_base_time (GST_ELEMENT (sink));
-      gst_inter_pipe_ilistener_push_event (listener, gst_event_ref (event),
-          basetime);
+      item = GST_MINI_OBJECT_CAST (gst_event_ref (event));
+      if (!gst_inter_pipe_sink_target_hold (target, item))
+        gst_inter_pipe_sink_target_dispatch (sink, target, item);
       break;
   }
+
+  gst_inter_pipe_sink_target_leave (target, outer);
 }
 
 static gboolean
 gst_inter_pipe_sink_event (GstBaseSink * base, GstEvent * event)
 {
   GstInterPipeSink *sink;
-  GHashTable *listeners;
-  gpointer data_array[2];
+  GstInterPipeSinkListeners *listeners;
+  guint i;
 
   sink = GST_INTER_PIPE_SINK (base);
 
-  g_mutex_lock (&sink->listeners_mutex);
-  listeners = GST_INTER_PIPE_SINK_LISTENERS (sink);
+  /* Cached buffers can't be decoded with new caps or after a seek */
+  if (GST_EVENT_CAPS == GST_EVENT_TYPE (event)
+      || GST_EVENT_FLUSH_STOP == GST_EVENT_TYPE (event)) {
+    g_mutex_lock (&sink->cache_mutex);
+    gst_inter_pipe_sink_cache_reset (sink);
+    g_mutex_unlock (&sink->cache_mutex);
+  }
 
   if (sink->forward_events) {
-    data_array[0] = sink;
-    data_array[1] = event;
-    g_hash_table_foreach (listeners, gst_inter_pipe_sink_forward_event,
-        (gpointer) data_array);
+    listeners = gst_inter_pipe_sink_get_listeners (sink);
+    for (i = 0; i < listeners->num_targets; i++)
+      gst_inter_pipe_sink_forward_event (sink, listeners->targets[i], event);
+    gst_inter_pipe_sink_listeners_unref (listeners);
   }
-  g_mutex_unlock (&sink->listeners_mutex);
+
   return GST_BASE_SINK_CLASS (gst_inter_pipe_sink_parent_class)->event (base,
       event);
 }
 
-/* Appsink Callbacks */
+/* Data flow */
+/* Buffers and buffer lists are pushed the same way */
 static void
-gst_inter_pipe_sink_push_to_listener (gpointer key, gpointer data,
-    gpointer user_data)
+gst_inter_pipe_sink_push_to_listener (GstInterPipeSink * sink,
+    GstInterPipeSinkTarget * target, GstMiniObject * data)
 {
-  GstInterPipeIListener *listener;
-  GstInterPipeSink *sink;
-  GstBuffer *buffer;
-  guint64 basetime;
-  gchar *listener_name;
-  gpointer *data_array = user_data;
+  gpointer outer;
 
-  sink = GST_INTER_PIPE_SINK (data_array[0]);
-  buffer = gst_buffer_ref (GST_BUFFER (data_array[1]));
+  if (!gst_inter_pipe_sink_target_enter (target, &outer))
+    return;
 
-  listener = GST_INTER_PIPE_ILISTENER (data);
-  listener_name = (gchar *) key;
+  GST_LOG_OBJECT (sink, "Forwarding %s %p to %s",
+      GST_IS_BUFFER (data) ? "buffer" : "buffer list", data,
+      gst_inter_pipe_ilistener_get_name (target->listener));
 
-  GST_LOG_OBJECT (sink, "Forwarding buffer %p to %s", buffer, listener_name);
+  data = gst_mini_object_ref (data);
+  if (!gst_inter_pipe_sink_target_hold (target, data))
+    gst_inter_pipe_sink_target_dispatch (sink, target, data);
 
-  basetime = gst_element_get_base_time (GST_ELEMENT (sink));
-  gst_inter_pipe_ilistener_push_buffer (listener, buffer, basetime);
+  gst_inter_pipe_sink_target_leave (target, outer);
 }
 
 static void
-gst_inter_pipe_sink_process_sample (GstInterPipeSink * sink, GstSample * sample)
+gst_inter_pipe_sink_process_data (GstInterPipeSink * sink,
+    GstMiniObject * data)
 {
-  GHashTable *listeners;
-  GstBuffer *buffer;
-  gpointer data[2];
-
-  g_mutex_lock (&sink->listeners_mutex);
-  listeners = GST_INTER_PIPE_SINK_LISTENERS (sink);
+  GstInterPipeSinkListeners *listeners;
+  GstBufferList *list;
+  guint i, len;
 
-  buffer = gst_sample_get_buffer (sample);
+  list = GST_IS_BUFFER_LIST (data) ? GST_BUFFER_LIST_CAST (data) : NULL;
+  len = list ? gst_buffer_list_length (list) : 1;
 
   /* Update last_buffer_timestamp */
-  sink->last_buffer_timestamp = GST_BUFFER_PTS (buffer);
+  sink->last_buffer_timestamp = GST_BUFFER_PTS (list ?
+      gst_buffer_list_get (list, len - 1) : GST_BUFFER_CAST (data));
 
-  GST_LOG_OBJECT (sink, "Received new buffer %p on node %s", buffer,
+  GST_LOG_OBJECT (sink, "Received %u new buffers on node %s", len,
       sink->node_name);
 
-  data[0] = sink;
-  data[1] = buffer;
-  g_hash_table_foreach (listeners, gst_inter_pipe_sink_push_to_listener, data);
-  gst_sample_unref (sample);
-
-  g_mutex_unlock (&sink->listeners_mutex);
+  /* New listeners take their replay from the cache in the same critical
+   * section that publishes them, so the buffer is either replayed or
+   * pushed to them, never both */
+  if (sink->gop_cache) {
+    g_mutex_lock (&sink->cache_mutex);
+    for (i = 0; i < len; i++)
+      gst_inter_pipe_sink_cache_buffer (sink, list ?
+          gst_buffer_list_get (list, i) : GST_BUFFER_CAST (data));
+    listeners = gst_inter_pipe_sink_get_listeners (sink);
+    g_mutex_unlock (&sink->cache_mutex);
+  } else {
+    listeners = gst_inter_pipe_sink_get_listeners (sink);
+  }
 
+  for (i = 0; i < listeners->num_targets; i++)
+    gst_inter_pipe_sink_push_to_listener (sink, listeners->targets[i], data);
+  gst_inter_pipe_sink_listeners_unref (listeners);
 }
 
 static GstFlowReturn
-gst_inter_pipe_sink_new_buffer (GstAppSink * asink, gpointer data)
+gst_inter_pipe_sink_render (GstBaseSink * base, GstBuffer * buffer)
 {
   GstInterPipeSink *sink;
-  GstSample *sample;
 
-  sink = GST_INTER_PIPE_SINK (asink);
+  sink = GST_INTER_PIPE_SINK (base);
 
-  sample = gst_app_sink_pull_sample (asink);
-  gst_inter_pipe_sink_process_sample (sink, sample);
+  gst_inter_pipe_sink_process_data (sink, GST_MINI_OBJECT_CAST (buffer));
 
   return GST_FLOW_OK;
 }
 
-
+/* The list crosses to the listeners as a whole, so packetized streams
+ * take one push per list instead of one per packet */
 static GstFlowReturn
-gst_inter_pipe_sink_new_preroll (GstAppSink * asink, gpointer data)
+gst_inter_pipe_sink_render_list (GstBaseSink * base, GstBufferList * list)
 {
   GstInterPipeSink *sink;
-  GstSample *sample;
 
-  sink = GST_INTER_PIPE_SINK (asink);
+  sink = GST_INTER_PIPE_SINK (base);
+
+  if (0 == gst_buffer_list_length (list))
+    return GST_FLOW_OK;
 
-  sample = gst_app_sink_pull_preroll (asink);
-  gst_inter_pipe_sink_process_sample (sink, sample);
+  gst_inter_pipe_sink_process_data (sink, GST_MINI_OBJECT_CAST (list));
 
   return GST_FLOW_OK;
 }
 
 static void
-gst_inter_pipe_sink_send_eos (gpointer key, gpointer data, gpointer user_data)
+gst_inter_pipe_sink_send_eos (GstInterPipeSink * sink,
+    GstInterPipeSinkTarget * target)
 {
-  GstInterPipeSink *sink;
-  GstInterPipeIListener *listener;
-  gchar *listener_name;
+  GstMiniObject *item;
+  gpointer outer;
 
-  sink = GST_INTER_PIPE_SINK (user_data);
-  listener = GST_INTER_PIPE_ILISTENER (data);
-  listener_name = (gchar *) key;
+  if (!gst_inter_pipe_sink_target_enter (target, &outer))
+    return;
 
-  GST_LOG_OBJECT (sink, "Forwarding EOS to %s", listener_name);
+  GST_LOG_OBJECT (sink, "Forwarding EOS to %s",
+      gst_inter_pipe_ilistener_get_name (target->listener));
 
-  gst_inter_pipe_ilistener_send_eos (listener);
+  /* EOS must not overtake the buffers still waiting in the queue */
+  item = GST_MINI_OBJECT_CAST (gst_event_new_eos ());
+  if (!gst_inter_pipe_sink_target_hold (target, item))
+    gst_inter_pipe_sink_target_dispatch (sink, target, item);
+
+  gst_inter_pipe_sink_target_leave (target, outer);
 }
 
 static void
 gst_inter_pipe_sink_eos (GstAppSink * asink, gpointer data)
 {
   GstInterPipeSink *sink;
-  GHashTable *listeners;
+  GstInterPipeSinkListeners *listeners;
+  guint i;
 
   sink = GST_INTER_PIPE_SINK (asink);
 
-  g_mutex_lock (&sink->listeners_mutex);
-  listeners = GST_INTER_PIPE_SINK_LISTENERS (sink);
-
   GST_LOG_OBJECT (sink, "Received new EOS on node %s", sink->node_name);
 
   if (sink->forward_eos) {
-    g_hash_table_foreach (listeners, gst_inter_pipe_sink_send_eos,
-        (gpointer) sink);
+    listeners = gst_inter_pipe_sink_get_listeners (sink);
+    for (i = 0; i < listeners->num_targets; i++)
+      gst_inter_pipe_sink_send_eos (sink, listeners->targets[i]);
+    gst_inter_pipe_sink_listeners_unref (listeners);
   } else {
     GST_LOG_OBJECT (sink, "Ignoring EOS");
   }
-  g_mutex_unlock (&sink->listeners_mutex);
+}
+
+/* Listeners snapshot */
+static GstInterPipeSinkListeners *
+gst_inter_pipe_sink_listeners_new (GstInterPipeSink * sink)
+{
+  GstInterPipeSinkListeners *listeners;
+  GHashTableIter iter;
+  gpointer key, value;
+  guint i = 0;
+
+  listeners = g_new0 (GstInterPipeSinkListeners, 1);
+  listeners->refcount = 1;
+  listeners->num_targets = g_hash_table_size (sink->targets);
+  listeners->targets = g_new0 (GstInterPipeSinkTarget *,
+      listeners->num_targets);
+
+  g_hash_table_iter_init (&iter, sink->targets);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    listeners->targets[i++] = gst_inter_pipe_sink_target_ref (value);
+
+  return listeners;
+}
+
+static GstInterPipeSinkListeners *
+gst_inter_pipe_sink_listeners_ref (GstInterPipeSinkListeners * listeners)
+{
+  g_atomic_int_inc (&listeners->refcount);
+
+  return listeners;
+}
+
+static void
+gst_inter_pipe_sink_listeners_unref (GstInterPipeSinkListeners * listeners)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&listeners->refcount))
+    return;
+
+  for (i = 0; i < listeners->num_targets; i++)
+    gst_inter_pipe_sink_target_unref (listeners->targets[i]);
+
+  g_free (listeners->targets);
+  g_free (listeners);
+}
+
+/* Lock free, the publisher keeps the old snapshot alive until every
+ * reader that may have loaded it took its reference */
+static GstInterPipeSinkListeners *
+gst_inter_pipe_sink_get_listeners (GstInterPipeSink * sink)
+{
+  GstInterPipeSinkListeners *listeners;
+
+  g_atomic_int_inc (&sink->snapshot_readers);
+  listeners = gst_inter_pipe_sink_listeners_ref (g_atomic_pointer_get
+      (&sink->snapshot));
+  g_atomic_int_add (&sink->snapshot_readers, -1);
+
+  return listeners;
+}
+
+/* Must be called with listeners_mutex held */
+static void
+gst_inter_pipe_sink_publish_listeners (GstInterPipeSink * sink)
+{
+  GstInterPipeSinkListeners *old;
+
+  old = sink->snapshot;
+  g_atomic_pointer_set (&sink->snapshot,
+      gst_inter_pipe_sink_listeners_new (sink));
+
+  /* A reader counted from here on already sees the new snapshot */
+  while (g_atomic_int_get (&sink->snapshot_readers))
+    g_thread_yield ();
+
+  gst_inter_pipe_sink_listeners_unref (old);
+}
+
+/* Delivery targets */
+static GstInterPipeSinkTarget *
+gst_inter_pipe_sink_target_new (GstInterPipeSink * sink,
+    GstInterPipeIListener * listener)
+{
+  GstInterPipeSinkTarget *target;
+
+  target = g_new0 (GstInterPipeSinkTarget, 1);
+  target->refcount = 1;
+  target->listener = g_object_ref (listener);
+  target->queue = NULL;
+  target->active = TRUE;
+  target->in_flight = 0;
+  g_mutex_init (&target->drain_mutex);
+  g_cond_init (&target->drain_cond);
+  target->replaying = FALSE;
+  g_queue_init (&target->held);
+  g_mutex_init (&target->replay_mutex);
+
+  if (sink->shared_delivery || sink->listener_queue_size
+      || sink->listener_queue_max_bytes || sink->listener_queue_max_time) {
+    GST_INFO_OBJECT (sink, "Delivering to %s through a queue of %u buffers, "
+        "%u bytes, %" GST_TIME_FORMAT,
+        gst_inter_pipe_ilistener_get_name (listener),
+        sink->listener_queue_size, sink->listener_queue_max_bytes,
+        GST_TIME_ARGS (sink->listener_queue_max_time));
+    target->queue = gst_inter_pipe_sink_queue_new (sink, listener);
+  }
+
+  return target;
+}
+
+static GstInterPipeSinkTarget *
+gst_inter_pipe_sink_target_ref (GstInterPipeSinkTarget * target)
+{
+  g_atomic_int_inc (&target->refcount);
+
+  return target;
+}
+
+static void
+gst_inter_pipe_sink_target_unref (GstInterPipeSinkTarget * target)
+{
+  GstMiniObject *item;
+
+  if (!g_atomic_int_dec_and_test (&target->refcount))
+    return;
+
+  while ((item = g_queue_pop_head (&target->held)))
+    gst_mini_object_unref (item);
+
+  if (target->queue)
+    gst_inter_pipe_sink_queue_unref (target->queue);
+  g_object_unref (target->listener);
+  g_mutex_clear (&target->drain_mutex);
+  g_cond_clear (&target->drain_cond);
+  g_mutex_clear (&target->replay_mutex);
+  g_free (target);
+}
+
+/* The target the calling thread is pushing into, so a listener removed
+ * from its own push doesn't wait for itself */
+static GPrivate gst_inter_pipe_sink_current_target;
+
+/* The removal may be waiting from one of the pushes, wake it up on
+ * every push that finishes */
+static void
+gst_inter_pipe_sink_target_release (GstInterPipeSinkTarget * target)
+{
+  g_atomic_int_add (&target->in_flight, -1);
+  if (G_LIKELY (g_atomic_int_get (&target->active)))
+    return;
+
+  g_mutex_lock (&target->drain_mutex);
+  g_cond_broadcast (&target->drain_cond);
+  g_mutex_unlock (&target->drain_mutex);
+}
+
+/* Announce the push before checking the target, so the removal either
+ * sees it in flight or the push sees the target inactive */
+static gboolean
+gst_inter_pipe_sink_target_enter (GstInterPipeSinkTarget * target,
+    gpointer * outer)
+{
+  g_atomic_int_inc (&target->in_flight);
+
+  if (G_UNLIKELY (!g_atomic_int_get (&target->active))) {
+    gst_inter_pipe_sink_target_release (target);
+    return FALSE;
+  }
+
+  *outer = g_private_get (&gst_inter_pipe_sink_current_target);
+  g_private_set (&gst_inter_pipe_sink_current_target, target);
+
+  return TRUE;
+}
+
+static void
+gst_inter_pipe_sink_target_leave (GstInterPipeSinkTarget * target,
+    gpointer outer)
+{
+  g_private_set (&gst_inter_pipe_sink_current_target, outer);
+  gst_inter_pipe_sink_target_release (target);
+}
+
+/* Waits out the pushes still running from older snapshots and stops
+ * the queue. Never call it with a lock held, a stuck listener must only
+ * hold up its own removal */
+static void
+gst_inter_pipe_sink_target_stop (GstInterPipeSinkTarget * target)
+{
+  gint own;
+
+  g_atomic_int_set (&target->active, FALSE);
+  own = g_private_get (&gst_inter_pipe_sink_current_target) == target;
+
+  g_mutex_lock (&target->drain_mutex);
+  while (g_atomic_int_get (&target->in_flight) > own)
+    g_cond_wait (&target->drain_cond, &target->drain_mutex);
+  g_mutex_unlock (&target->drain_mutex);
+
+  if (target->queue)
+    gst_inter_pipe_sink_queue_stop (target->queue);
+
+  gst_inter_pipe_sink_target_unref (target);
+}
+
+/* Takes @item if the target is still being replayed to. Non-serialized
+ * events don't keep a place in the stream and are never held */
+static gboolean
+gst_inter_pipe_sink_target_hold (GstInterPipeSinkTarget * target,
+    GstMiniObject * item)
+{
+  gboolean held = FALSE;
+
+  if (G_LIKELY (!g_atomic_int_get (&target->replaying)))
+    return FALSE;
+
+  if (GST_IS_EVENT (item) && !GST_EVENT_IS_SERIALIZED (GST_EVENT_CAST (item)))
+    return FALSE;
+
+  g_mutex_lock (&target->replay_mutex);
+  if (target->replaying) {
+    g_queue_push_tail (&target->held, item);
+    held = TRUE;
+  }
+  g_mutex_unlock (&target->replay_mutex);
+
+  return held;
+}
+
+/* Must be called between target_enter and target_leave */
+static void
+gst_inter_pipe_sink_target_dispatch (GstInterPipeSink * sink,
+    GstInterPipeSinkTarget * target, GstMiniObject * item)
+{
+  GstInterPipeSinkQueue *queue;
+
+  queue = target->queue;
+
+  /* A flush drops what is queued and goes straight to the listener */
+  if (queue && GST_IS_EVENT (item)
+      && GST_EVENT_FLUSH_START == GST_EVENT_TYPE (item)) {
+    gst_inter_pipe_sink_queue_flush (queue);
+    queue = NULL;
+  }
+
+  /* Serialized events keep their place among the queued buffers */
+  if (queue && (!GST_IS_EVENT (item)
+          || GST_EVENT_IS_SERIALIZED (GST_EVENT_CAST (item))))
+    gst_inter_pipe_sink_queue_push (queue, item);
+  else
+    gst_inter_pipe_sink_deliver (sink, target->listener, item);
+}
+
+/* Brings a new listener up to date without holding any lock, then
+ * hands over the live items held meanwhile until none are left. The
+ * replay and the live items come from the same critical section of
+ * the streaming thread, so no buffer is missed or delivered twice */
+static void
+gst_inter_pipe_sink_target_replay (GstInterPipeSink * sink,
+    GstInterPipeSinkTarget * target, GQueue * replay)
+{
+  GstMiniObject *item;
+  gpointer outer;
+
+  GST_INFO_OBJECT (sink, "Replaying %u items to %s",
+      g_queue_get_length (replay),
+      gst_inter_pipe_ilistener_get_name (target->listener));
+
+  while (TRUE) {
+    while ((item = g_queue_pop_head (replay))) {
+      if (gst_inter_pipe_sink_target_enter (target, &outer)) {
+        gst_inter_pipe_sink_target_dispatch (sink, target, item);
+        gst_inter_pipe_sink_target_leave (target, outer);
+      } else {
+        gst_mini_object_unref (item);
+      }
+    }
+
+    g_mutex_lock (&target->replay_mutex);
+    if (g_queue_is_empty (&target->held)) {
+      g_atomic_int_set (&target->replaying, FALSE);
+      g_mutex_unlock (&target->replay_mutex);
+      break;
+    }
+    *replay = target->held;
+    g_queue_init (&target->held);
+    g_mutex_unlock (&target->replay_mutex);
+  }
+}
+
+/* The element's base time without its object lock, so a
+ * gst_element_set_base_time() while PLAYING applies from the next
+ * buffer on. Hosts without atomic 64-bit loads take the lock */
+static GstClockTime
+gst_inter_pipe_sink_get_base_time (GstInterPipeSink * sink)
+{
+#if GLIB_SIZEOF_VOID_P == 8
+  return *(volatile GstClockTime *) & GST_ELEMENT_CAST (sink)->base_time;
+#else
+  return gst_element_get_base_time (GST_ELEMENT_CAST (sink));
+#endif
+}
+
+static void
+gst_inter_pipe_sink_deliver (GstInterPipeSink * sink,
+    GstInterPipeIListener * listener, GstMiniObject * item)
+{
+  guint64 basetime;
+
+  basetime = gst_inter_pipe_sink_get_base_time (sink);
+
+  if (GST_IS_BUFFER (item)) {
+    gst_inter_pipe_ilistener_push_buffer (listener, GST_BUFFER_CAST (item),
+        basetime);
+  } else if (GST_IS_BUFFER_LIST (item)) {
+    gst_inter_pipe_ilistener_push_buffer_list (listener,
+        GST_BUFFER_LIST_CAST (item), basetime);
+  } else if (GST_EVENT_TYPE (item) == GST_EVENT_EOS) {
+    gst_inter_pipe_ilistener_send_eos (listener);
+    gst_event_unref (GST_EVENT_CAST (item));
+  } else {
+    gst_inter_pipe_ilistener_push_event (listener, GST_EVENT_CAST (item),
+        basetime);
+  }
+}
+
+/* Listener delivery queues */
+static GstInterPipeSinkQueue *
+gst_inter_pipe_sink_queue_ref (GstInterPipeSinkQueue * queue)
+{
+  g_atomic_int_inc (&queue->refcount);
+
+  return queue;
+}
+
+static void
+gst_inter_pipe_sink_queue_clear (GstInterPipeSinkQueue * queue)
+{
+  GstMiniObject *item;
+
+  while ((item = g_queue_pop_head (&queue->items)))
+    gst_mini_object_unref (item);
+  queue->num_buffers = 0;
+  queue->num_bytes = 0;
+  queue->last_ts = GST_CLOCK_TIME_NONE;
+}
+
+static guint
+gst_inter_pipe_sink_data_size (GstMiniObject * data)
+{
+  GstBufferList *list;
+  guint i, len, size = 0;
+
+  if (GST_IS_BUFFER (data))
+    return gst_buffer_get_size (GST_BUFFER_CAST (data));
+
+  list = GST_BUFFER_LIST_CAST (data);
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++)
+    size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+  return size;
+}
+
+/* The timestamp of the first buffer in @data */
+static GstClockTime
+gst_inter_pipe_sink_data_timestamp (GstMiniObject * data)
+{
+  GstBufferList *list;
+
+  if (GST_IS_BUFFER (data))
+    return GST_BUFFER_DTS_OR_PTS (GST_BUFFER_CAST (data));
+
+  list = GST_BUFFER_LIST_CAST (data);
+  if (0 == gst_buffer_list_length (list))
+    return GST_CLOCK_TIME_NONE;
+
+  return GST_BUFFER_DTS_OR_PTS (gst_buffer_list_get (list, 0));
+}
+
+/* Must be called with the queue mutex held */
+static gboolean
+gst_inter_pipe_sink_queue_is_full (GstInterPipeSinkQueue * queue)
+{
+  GList *l;
+  GstClockTime first_ts;
+
+  if (queue->max_buffers && queue->num_buffers >= queue->max_buffers)
+    return TRUE;
+
+  if (queue->max_bytes && queue->num_bytes >= queue->max_bytes)
+    return TRUE;
+
+  if (!queue->max_time || !GST_CLOCK_TIME_IS_VALID (queue->last_ts))
+    return FALSE;
+
+  for (l = queue->items.head; l != NULL; l = l->next) {
+    if (GST_INTER_PIPE_SINK_IS_DATA (l->data))
+      break;
+  }
+  if (!l)
+    return FALSE;
+
+  first_ts = gst_inter_pipe_sink_data_timestamp (GST_MINI_OBJECT_CAST
+      (l->data));
+
+  return GST_CLOCK_TIME_IS_VALID (first_ts) && queue->last_ts > first_ts
+      && queue->last_ts - first_ts >= queue->max_time;
+}
+
+/* Must be called with the queue mutex held */
+static void
+gst_inter_pipe_sink_queue_remove_data (GstInterPipeSinkQueue * queue,
+    GstMiniObject * data)
+{
+  queue->num_buffers--;
+  queue->num_bytes -= MIN (queue->num_bytes,
+      gst_inter_pipe_sink_data_size (data));
+  if (0 == queue->num_buffers)
+    queue->last_ts = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_inter_pipe_sink_queue_unref (GstInterPipeSinkQueue * queue)
+{
+  if (!g_atomic_int_dec_and_test (&queue->refcount))
+    return;
+
+  gst_inter_pipe_sink_queue_clear (queue);
+  g_mutex_clear (&queue->mutex);
+  g_cond_clear (&queue->cond);
+  g_free (queue);
+}
+
+static gpointer
+gst_inter_pipe_sink_queue_loop (gpointer user_data)
+{
+  GstInterPipeSinkQueue *queue = user_data;
+  GstMiniObject *item;
+
+  g_mutex_lock (&queue->mutex);
+  while (TRUE) {
+    while (!queue->flushing && g_queue_is_empty (&queue->items))
+      g_cond_wait (&queue->cond, &queue->mutex);
+
+    if (queue->flushing)
+      break;
+
+    item = g_queue_pop_head (&queue->items);
+    if (GST_INTER_PIPE_SINK_IS_DATA (item))
+      gst_inter_pipe_sink_queue_remove_data (queue, item);
+
+    /* Wake up the node if it is waiting for room in the queue */
+    g_cond_broadcast (&queue->cond);
+    g_mutex_unlock (&queue->mutex);
+
+    gst_inter_pipe_sink_deliver (queue->sink, queue->listener, item);
+
+    g_mutex_lock (&queue->mutex);
+  }
+  g_mutex_unlock (&queue->mutex);
+
+  gst_inter_pipe_sink_queue_unref (queue);
+
+  return NULL;
+}
+
+/* Kept apart from the pool the interpipesrc tasks run on, a delivery
+ * blocked on a full source must not keep that source from draining */
+static gpointer
+gst_inter_pipe_sink_create_delivery_pool (gpointer data)
+{
+  GstTaskPool *pool;
+
+  pool = gst_inter_pipe_task_pool_new (0);
+  if (g_getenv ("GST_INTERPIPE_PIN_DELIVERY_WORKERS"))
+    gst_inter_pipe_task_pool_set_pinned (pool, TRUE);
+  gst_task_pool_prepare (pool, NULL);
+
+  return pool;
+}
+
+static GstTaskPool *
+gst_inter_pipe_sink_get_delivery_pool (void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, gst_inter_pipe_sink_create_delivery_pool, NULL);
+
+  return once.retval;
+}
+
+/* Runs on a shared worker. Only one job per queue is pushed at a time,
+ * so the listener still gets its items in order */
+static void
+gst_inter_pipe_sink_queue_drain (gpointer user_data)
+{
+  GstInterPipeSinkQueue *queue = user_data;
+  GstMiniObject *item;
+  guint delivered = 0;
+
+  g_mutex_lock (&queue->mutex);
+  queue->worker = g_thread_self ();
+  while (!queue->flushing && !g_queue_is_empty (&queue->items)) {
+    /* Let the queues waiting for a worker have a turn */
+    if (delivered++ == SHARED_DELIVERY_BATCH) {
+      queue->worker = NULL;
+      g_mutex_unlock (&queue->mutex);
+      gst_inter_pipe_sink_queue_schedule (queue);
+      return;
+    }
+
+    item = g_queue_pop_head (&queue->items);
+    if (GST_INTER_PIPE_SINK_IS_DATA (item))
+      gst_inter_pipe_sink_queue_remove_data (queue, item);
+
+    /* Wake up the node if it is waiting for room in the queue */
+    g_cond_broadcast (&queue->cond);
+    g_mutex_unlock (&queue->mutex);
+
+    gst_inter_pipe_sink_deliver (queue->sink, queue->listener, item);
+
+    g_mutex_lock (&queue->mutex);
+  }
+  queue->worker = NULL;
+  queue->scheduled = FALSE;
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->mutex);
+
+  gst_inter_pipe_sink_queue_unref (queue);
+}
+
+/* Takes the reference the job holds, a job that reschedules passes
+ * its own on */
+static void
+gst_inter_pipe_sink_queue_schedule (GstInterPipeSinkQueue * queue)
+{
+  GError *error = NULL;
+
+  gst_task_pool_push (gst_inter_pipe_sink_get_delivery_pool (),
+      gst_inter_pipe_sink_queue_drain, queue, &error);
+  if (error)
+    goto push_failed;
+
+  return;
+
+push_failed:
+  {
+    GST_ERROR_OBJECT (queue->sink, "Could not schedule the delivery to %s: %s",
+        gst_inter_pipe_ilistener_get_name (queue->listener), error->message);
+    g_error_free (error);
+
+    g_mutex_lock (&queue->mutex);
+    gst_inter_pipe_sink_queue_clear (queue);
+    queue->scheduled = FALSE;
+    g_cond_broadcast (&queue->cond);
+    g_mutex_unlock (&queue->mutex);
+    gst_inter_pipe_sink_queue_unref (queue);
+  }
+}
+
+static GstInterPipeSinkQueue *
+gst_inter_pipe_sink_queue_new (GstInterPipeSink * sink,
+    GstInterPipeIListener * listener)
+{
+  GstInterPipeSinkQueue *queue;
+
+  queue = g_new0 (GstInterPipeSinkQueue, 1);
+  queue->refcount = 1;
+  queue->sink = sink;
+  queue->listener = listener;
+  queue->max_buffers = sink->listener_queue_size;
+  queue->max_bytes = sink->listener_queue_max_bytes;
+  queue->max_time = sink->listener_queue_max_time;
+  queue->last_ts = GST_CLOCK_TIME_NONE;
+  queue->flushing = FALSE;
+  queue->shared = sink->shared_delivery;
+  queue->scheduled = FALSE;
+  queue->worker = NULL;
+  g_queue_init (&queue->items);
+  g_mutex_init (&queue->mutex);
+  g_cond_init (&queue->cond);
+
+  if (queue->shared)
+    return queue;
+
+  /* The delivery thread holds its own reference */
+  queue->thread = g_thread_new ("interpipequeue", gst_inter_pipe_sink_queue_loop,
+      gst_inter_pipe_sink_queue_ref (queue));
+
+  return queue;
+}
+
+/* Stops the deliveries without waiting for the one in progress, so it
+ * can be called with the listeners mutex held */
+static void
+gst_inter_pipe_sink_queue_close (GstInterPipeSinkQueue * queue)
+{
+  g_mutex_lock (&queue->mutex);
+  queue->flushing = TRUE;
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->mutex);
+}
+
+/* Waits for the delivery in progress, which may be pushing into a
+ * listener that calls back into the node. Never call it with a lock
+ * held, a stuck listener must only hold up its own removal */
+static void
+gst_inter_pipe_sink_queue_stop (GstInterPipeSinkQueue * queue)
+{
+  gst_inter_pipe_sink_queue_close (queue);
+
+  /* Unless the delivery is removing itself. A job still waiting for a
+   * worker won't deliver anything once it runs */
+  g_mutex_lock (&queue->mutex);
+  while (queue->worker && queue->worker != g_thread_self ())
+    g_cond_wait (&queue->cond, &queue->mutex);
+  g_mutex_unlock (&queue->mutex);
+
+  GST_DEBUG_OBJECT (queue->sink, "Stopping delivery queue of %s, %"
+      G_GUINT64_FORMAT " buffers dropped",
+      gst_inter_pipe_ilistener_get_name (queue->listener), queue->dropped);
+
+  /* The listener may be removed from its own delivery thread */
+  if (queue->thread == g_thread_self ())
+    g_thread_unref (queue->thread);
+  else if (queue->thread)
+    g_thread_join (queue->thread);
+  queue->thread = NULL;
+}
+
+static void
+gst_inter_pipe_sink_queue_drop_oldest (GstInterPipeSinkQueue * queue)
+{
+  GList *l;
+
+  /* Only buffers are dropped, serialized events must reach the listener */
+  for (l = queue->items.head; l != NULL; l = l->next) {
+    if (GST_INTER_PIPE_SINK_IS_DATA (l->data)) {
+      gst_inter_pipe_sink_queue_remove_data (queue,
+          GST_MINI_OBJECT_CAST (l->data));
+      gst_mini_object_unref (GST_MINI_OBJECT_CAST (l->data));
+      g_queue_delete_link (&queue->items, l);
+      queue->dropped++;
+      return;
+    }
+  }
+}
+
+static void
+gst_inter_pipe_sink_queue_push (GstInterPipeSinkQueue * queue,
+    GstMiniObject * item)
+{
+  gboolean is_buffer;
+  gboolean schedule;
+
+  is_buffer = GST_INTER_PIPE_SINK_IS_DATA (item);
+
+  g_mutex_lock (&queue->mutex);
+
+  while (is_buffer && !queue->flushing
+      && gst_inter_pipe_sink_queue_is_full (queue)) {
+    GstInterPipeSinkLeaky leaky = queue->sink->listener_queue_leaky;
+
+    if (GST_INTER_PIPE_SINK_LEAKY_UPSTREAM == leaky) {
+      queue->dropped++;
+      GST_LOG_OBJECT (queue->sink, "Queue of %s full, dropping new buffer",
+          gst_inter_pipe_ilistener_get_name (queue->listener));
+      goto drop;
+    } else if (GST_INTER_PIPE_SINK_LEAKY_DOWNSTREAM == leaky) {
+      GST_LOG_OBJECT (queue->sink, "Queue of %s full, dropping old buffer",
+          gst_inter_pipe_ilistener_get_name (queue->listener));
+      gst_inter_pipe_sink_queue_drop_oldest (queue);
+    } else {
+      g_cond_wait (&queue->cond, &queue->mutex);
+    }
+  }
+
+  if (queue->flushing)
+    goto drop;
+
+  g_queue_push_tail (&queue->items, item);
+  if (is_buffer) {
+    GstClockTime ts;
+
+    queue->num_buffers++;
+    queue->num_bytes += gst_inter_pipe_sink_data_size (item);
+    ts = gst_inter_pipe_sink_data_timestamp (item);
+    if (GST_CLOCK_TIME_IS_VALID (ts))
+      queue->last_ts = ts;
+  }
+
+  schedule = queue->shared && !queue->scheduled;
+  if (schedule)
+    queue->scheduled = TRUE;
+
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->mutex);
+
+  if (schedule)
+    gst_inter_pipe_sink_queue_schedule (gst_inter_pipe_sink_queue_ref (queue));
+  return;
+
+drop:
+  {
+    g_mutex_unlock (&queue->mutex);
+    gst_mini_object_unref (item);
+  }
+}
+
+static void
+gst_inter_pipe_sink_queue_flush (GstInterPipeSinkQueue * queue)
+{
+  g_mutex_lock (&queue->mutex);
+  gst_inter_pipe_sink_queue_clear (queue);
+  g_cond_broadcast (&queue->cond);
+  g_mutex_unlock (&queue->mutex);
+}
+
+/* GOP cache, must be called with cache_mutex held */
+static void
+gst_inter_pipe_sink_cache_clear (GQueue * cache)
+{
+  GstBuffer *buffer;
+
+  while ((buffer = g_queue_pop_head (cache)))
+    gst_buffer_unref (buffer);
+}
+
+static void
+gst_inter_pipe_sink_cache_reset (GstInterPipeSink * sink)
+{
+  gst_inter_pipe_sink_cache_clear (&sink->cache_headers);
+  gst_inter_pipe_sink_cache_clear (&sink->cache);
+  sink->cache_bytes = 0;
+  sink->cache_last_header = FALSE;
+}
+
+static gboolean
+gst_inter_pipe_sink_cache_is_full (GstInterPipeSink * sink)
+{
+  GstBuffer *first;
+  GstBuffer *last;
+  GstClockTime start;
+  GstClockTime stop;
+
+  if (sink->gop_cache_max_bytes && sink->cache_bytes > sink->gop_cache_max_bytes)
+    return TRUE;
+
+  if (!sink->gop_cache_max_time)
+    return FALSE;
+
+  first = g_queue_peek_head (&sink->cache);
+  last = g_queue_peek_tail (&sink->cache);
+  start = GST_BUFFER_DTS_OR_PTS (first);
+  stop = GST_BUFFER_DTS_OR_PTS (last);
+
+  return GST_CLOCK_TIME_IS_VALID (start) && GST_CLOCK_TIME_IS_VALID (stop)
+      && stop > start && stop - start > sink->gop_cache_max_time;
+}
+
+static void
+gst_inter_pipe_sink_cache_buffer (GstInterPipeSink * sink, GstBuffer * buffer)
+{
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_HEADER)) {
+    /* A new set of headers replaces the previous one */
+    if (!sink->cache_last_header)
+      gst_inter_pipe_sink_cache_clear (&sink->cache_headers);
+    g_queue_push_tail (&sink->cache_headers, gst_buffer_ref (buffer));
+    sink->cache_last_header = TRUE;
+    return;
+  }
+
+  sink->cache_last_header = FALSE;
+
+  if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    gst_inter_pipe_sink_cache_clear (&sink->cache);
+    sink->cache_bytes = 0;
+  } else if (g_queue_is_empty (&sink->cache)) {
+    /* Not decodable without its keyframe, wait for the next one */
+    return;
+  }
+
+  g_queue_push_tail (&sink->cache, gst_buffer_ref (buffer));
+  sink->cache_bytes += gst_buffer_get_size (buffer);
+
+  if (gst_inter_pipe_sink_cache_is_full (sink)) {
+    GST_DEBUG_OBJECT (sink, "GOP exceeds the cache limits, dropping it until "
+        "the next keyframe");
+    gst_inter_pipe_sink_cache_clear (&sink->cache);
+    sink->cache_bytes = 0;
+  }
+}
+
+static void
+gst_inter_pipe_sink_cache_snapshot (GstInterPipeSink * sink, GQueue * replay)
+{
+  GList *l;
+
+  if (g_queue_is_empty (&sink->cache))
+    return;
+
+  GST_DEBUG_OBJECT (sink, "Taking %u headers and %u cached buffers",
+      g_queue_get_length (&sink->cache_headers),
+      g_queue_get_length (&sink->cache));
+
+  for (l = sink->cache_headers.head; l != NULL; l = l->next)
+    g_queue_push_tail (replay, gst_buffer_ref (l->data));
+  for (l = sink->cache.head; l != NULL; l = l->next)
+    g_queue_push_tail (replay, gst_buffer_ref (l->data));
+}
+
+/* Caps and EOS are skipped by the regular event forwarding */
+static gboolean
+gst_inter_pipe_sink_snapshot_sticky_event (GstPad * pad, GstEvent ** event,
+    gpointer user_data)
+{
+  gpointer *data = user_data;
+  GstInterPipeSink *sink;
+  GQueue *replay;
+  GstEvent *copy;
+
+  sink = GST_INTER_PIPE_SINK (data[0]);
+  replay = data[1];
+
+  if (GST_EVENT_CAPS == GST_EVENT_TYPE (*event)
+      || GST_EVENT_EOS == GST_EVENT_TYPE (*event))
+    return TRUE;
+
+  GST_DEBUG_OBJECT (sink, "Taking sticky event %s",
+      GST_EVENT_TYPE_NAME (*event));
+
+  /* The stored event is shared with the pad, don't retimestamp it */
+  copy = gst_event_copy (*event);
+  GST_EVENT_TIMESTAMP (copy) = sink->last_buffer_timestamp;
+  g_queue_push_tail (replay, copy);
+
+  return TRUE;
 }
 
 /* GstInterPipeINode interface implementation */
@@ -723,6 +2086,7 @@ gst_inter_pipe_inode_init (GstInterPipeINodeInterface * iface)
   iface->add_listener = gst_inter_pipe_sink_add_listener;
   iface->remove_listener = gst_inter_pipe_sink_remove_listener;
   iface->receive_event = gst_inter_pipe_sink_receive_event;
+  iface->rejoin_listener = gst_inter_pipe_sink_rejoin_listener;
 }
 
 static gboolean
@@ -732,8 +2096,13 @@ gst_inter_pipe_sink_add_listener (GstInterPipeINode * iface,
   GstInterPipeSink *sink;
   GHashTable *listeners;
   const gchar *listener_name;
+  gpointer key;
   GstCaps *srccaps, *sinkcaps;
   gboolean src_negotiated;
+  GstInterPipeSinkTarget *target;
+  GstMessage *message;
+  GQueue replay = G_QUEUE_INIT;
+  gboolean replaying;
 
   g_return_val_if_fail (iface, FALSE);
   g_return_val_if_fail (listener, FALSE);
@@ -742,6 +2111,7 @@ gst_inter_pipe_sink_add_listener (GstInterPipeINode * iface,
 
   listeners = GST_INTER_PIPE_SINK_LISTENERS (sink);
   listener_name = gst_inter_pipe_ilistener_get_name (listener);
+  key = listener;
 
   GST_INFO_OBJECT (sink, "Adding new listener %s", listener_name);
 
@@ -799,14 +2169,49 @@ gst_inter_pipe_sink_add_listener (GstInterPipeINode * iface,
 
 add_to_list:
   g_mutex_lock (&sink->listeners_mutex);
-  if (g_hash_table_contains (listeners, listener_name))
+  if (g_hash_table_contains (listeners, key))
     goto already_registered;
 
-  g_hash_table_insert (listeners, (gpointer) listener_name,
+  g_hash_table_insert (listeners, key,
       (gpointer) listener);
 
+  target = gst_inter_pipe_sink_target_new (sink, listener);
+  g_hash_table_insert (sink->targets, key, target);
+
+  /* Bring the listener up to date before it sees live data: the sticky
+   * events first, so it starts on the right segment, then the GOP. They
+   * are only taken here and replayed once the locks are released, the
+   * live data waits in the target until then */
+  g_mutex_lock (&sink->cache_mutex);
+  if (sink->forward_events) {
+    gpointer data[2];
+
+    data[0] = sink;
+    data[1] = &replay;
+    gst_pad_sticky_events_foreach (GST_INTER_PIPE_SINK_PAD (sink),
+        gst_inter_pipe_sink_snapshot_sticky_event, data);
+  }
+  gst_inter_pipe_sink_cache_snapshot (sink, &replay);
+  replaying = !g_queue_is_empty (&replay);
+  if (replaying) {
+    gst_inter_pipe_sink_target_ref (target);
+    g_atomic_int_set (&target->replaying, TRUE);
+  }
+  gst_inter_pipe_sink_publish_listeners (sink);
+  g_mutex_unlock (&sink->cache_mutex);
+
+  /* Resume an idle upstream now that there is somebody to feed */
+  message = gst_inter_pipe_sink_update_idle (sink);
   g_mutex_unlock (&sink->listeners_mutex);
 
+  if (replaying) {
+    gst_inter_pipe_sink_target_replay (sink, target, &replay);
+    gst_inter_pipe_sink_target_unref (target);
+  }
+
+  if (message)
+    gst_element_post_message (GST_ELEMENT (sink), message);
+
   return TRUE;
 
 /* Errors */
@@ -844,6 +2249,57 @@ error:
   }
 }
 
+/* The listener was set up by an earlier add_listener and only missed
+ * the data pushed meanwhile, so its caps are kept and nothing is
+ * replayed */
+static gboolean
+gst_inter_pipe_sink_rejoin_listener (GstInterPipeINode * iface,
+    GstInterPipeIListener * listener)
+{
+  GstInterPipeSink *sink;
+  GHashTable *listeners;
+  const gchar *listener_name;
+  gpointer key;
+  GstMessage *message;
+
+  g_return_val_if_fail (iface, FALSE);
+  g_return_val_if_fail (listener, FALSE);
+
+  sink = GST_INTER_PIPE_SINK (iface);
+
+  listeners = GST_INTER_PIPE_SINK_LISTENERS (sink);
+  listener_name = gst_inter_pipe_ilistener_get_name (listener);
+  key = listener;
+
+  GST_INFO_OBJECT (sink, "Rejoining listener %s", listener_name);
+
+  g_mutex_lock (&sink->listeners_mutex);
+  if (g_hash_table_contains (listeners, key))
+    goto already_registered;
+
+  g_hash_table_insert (listeners, key, (gpointer) listener);
+  g_hash_table_insert (sink->targets, key,
+      gst_inter_pipe_sink_target_new (sink, listener));
+  gst_inter_pipe_sink_publish_listeners (sink);
+
+  message = gst_inter_pipe_sink_update_idle (sink);
+  g_mutex_unlock (&sink->listeners_mutex);
+
+  if (message)
+    gst_element_post_message (GST_ELEMENT (sink), message);
+
+  return TRUE;
+
+already_registered:
+  {
+    GST_WARNING_OBJECT (sink, "Listener %s already registered in node %s",
+        listener_name, GST_OBJECT_NAME (sink));
+    g_mutex_unlock (&sink->listeners_mutex);
+
+    return TRUE;
+  }
+}
+
 static gboolean
 gst_inter_pipe_sink_remove_listener (GstInterPipeINode * iface,
     GstInterPipeIListener * listener)
@@ -851,24 +2307,44 @@ gst_inter_pipe_sink_remove_listener (GstInterPipeINode * iface,
   GstInterPipeSink *sink;
   GHashTable *listeners;
   const gchar *listener_name;
+  gpointer key;
+  GstMessage *message;
+  GstInterPipeSinkTarget *target;
 
   sink = GST_INTER_PIPE_SINK (iface);
   g_mutex_lock (&sink->listeners_mutex);
 
   listeners = GST_INTER_PIPE_SINK_LISTENERS (sink);
   listener_name = gst_inter_pipe_ilistener_get_name (listener);
+  key = listener;
 
   GST_INFO_OBJECT (sink, "Removing listener %s", listener_name);
 
-  if (!g_hash_table_remove (listeners, listener_name))
+  if (!g_hash_table_remove (listeners, key))
     goto not_registered;
 
+  /* Stop publishing the listener before tearing its target down, the
+   * pushes from older snapshots are waited out below */
+  target = g_hash_table_lookup (sink->targets, key);
+  g_hash_table_steal (sink->targets, key);
+  gst_inter_pipe_sink_publish_listeners (sink);
+  g_atomic_int_set (&target->active, FALSE);
+  if (target->queue)
+    gst_inter_pipe_sink_queue_close (target->queue);
+
   if (0 == g_hash_table_size (listeners) && sink->caps_negotiated) {
     gst_caps_unref (sink->caps_negotiated);
     sink->caps_negotiated = NULL;
   }
+  message = gst_inter_pipe_sink_update_idle (sink);
   g_mutex_unlock (&sink->listeners_mutex);
 
+  /* The listener gets nothing from this node once this returns */
+  gst_inter_pipe_sink_target_stop (target);
+
+  if (message)
+    gst_element_post_message (GST_ELEMENT (sink), message);
+
   return TRUE;
 
 not_registered:
@@ -884,13 +2360,17 @@ static gboolean
 gst_inter_pipe_sink_receive_event (GstInterPipeINode * iface, GstEvent * event)
 {
   GstInterPipeSink *self;
-  GHashTable *listeners;
+  GstInterPipeSinkListeners *listeners;
+  guint num_listeners;
   GstPad *sinkpad;
 
   self = GST_INTER_PIPE_SINK (iface);
-  listeners = GST_INTER_PIPE_SINK_LISTENERS (self);
 
-  if (g_hash_table_size (listeners) != 1) {
+  listeners = gst_inter_pipe_sink_get_listeners (self);
+  num_listeners = listeners->num_targets;
+  gst_inter_pipe_sink_listeners_unref (listeners);
+
+  if (num_listeners != 1) {
     gst_event_unref (event);
     goto multiple_listeners;
   }
@@ -46,12 +46,26 @@
 #include "gstinterpipe.h"
 #include "gstinterpipesrc.h"
 #include "gstinterpipeilistener.h"
+#include "gstinterpipetaskpool.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_inter_pipe_src_debug);
 #define GST_CAT_DEFAULT gst_inter_pipe_src_debug
 
+/* Stops the parked streaming tasks of shared-task sources */
+static GThreadPool *gst_inter_pipe_src_parker = NULL;
+
+/* Runs the scheduled switches, away from the thread of the node left */
+static GThreadPool *gst_inter_pipe_src_switcher = NULL;
+
 #define GST_INTER_PIPE_SRC_PAD(obj)  (GST_BASE_SRC_CAST (obj)->srcpad)
 
+/* A scheduled switch handed to the switcher */
+typedef struct
+{
+  GstInterPipeSrc *src;
+  gchar *node_name;
+} GstInterPipeSrcSwitch;
+
 enum
 {
   PROP_0,
@@ -60,9 +74,33 @@ enum
   PROP_ALLOW_RENEGOTIATION,
   PROP_STREAM_SYNC,
   PROP_ACCEPT_EVENTS,
-  PROP_ACCEPT_EOS_EVENT
+  PROP_ACCEPT_EOS_EVENT,
+  PROP_SWITCH_MODE,
+  PROP_DIRECT_PUSH,
+  PROP_TRANSPORT,
+  PROP_RING_SIZE,
+  PROP_QUEUE_MAX_BUFFERS,
+  PROP_QUEUE_MAX_BYTES,
+  PROP_QUEUE_MAX_TIME,
+  PROP_QUEUE_LEAKY,
+  PROP_FLUSH_ON_SWITCH,
+  PROP_MAX_LATENESS,
+  PROP_DROPPED_LATE,
+  PROP_SHARED_TASK
+};
+
+#define DEFAULT_RING_SIZE 64
+/* Items a shared task takes before handing its thread to a waiting one */
+#define SHARED_TASK_SLICE 32
+
+enum
+{
+  SIGNAL_SCHEDULE_SWITCH,
+  LAST_SIGNAL
 };
 
+static guint gst_inter_pipe_src_signals[LAST_SIGNAL] = { 0 };
+
 static void gst_inter_pipe_src_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_inter_pipe_src_get_property (GObject * object, guint prop_id,
@@ -82,25 +120,97 @@ static gboolean gst_inter_pipe_src_node_added (GstInterPipeIListener * listener,
     const gchar * node_name);
 static gboolean gst_inter_pipe_src_node_removed (GstInterPipeIListener *
     listener, const gchar * node_name);
+static void gst_inter_pipe_src_attached (GstInterPipeIListener * listener,
+    GstInterPipeINode * node);
+static gboolean gst_inter_pipe_src_push_buffer_list (GstInterPipeIListener *
+    iface, GstBufferList * list, guint64 basetime);
 static gboolean gst_inter_pipe_src_push_buffer (GstInterPipeIListener * iface,
     GstBuffer * buffer, guint64 basetime);
 static gboolean gst_inter_pipe_src_push_event (GstInterPipeIListener * iface,
     GstEvent * event, guint64 basetime);
 static gboolean gst_inter_pipe_src_send_eos (GstInterPipeIListener * iface);
 static gboolean gst_inter_pipe_src_listen_node (GstInterPipeSrc * src,
-    const gchar * node_name);
+    const gchar * node_name, GstInterPipeINode * node);
+static gboolean gst_inter_pipe_src_schedule_switch (GstInterPipeSrc * src,
+    const gchar * node_name, guint64 running_time);
+static gchar *gst_inter_pipe_src_take_scheduled_switch (GstInterPipeSrc * src,
+    GstBuffer * buffer, guint64 basetime);
+static gboolean gst_inter_pipe_src_switch_on_keyframe (GstInterPipeSrc * src,
+    const gchar * node_name, GstInterPipeINode * node);
+static GstClockTime gst_inter_pipe_src_get_base_time (GstInterPipeSrc * src);
 static gboolean gst_inter_pipe_src_start (GstBaseSrc * base);
 static gboolean gst_inter_pipe_src_stop (GstBaseSrc * base);
 static gboolean gst_inter_pipe_src_event (GstBaseSrc * base, GstEvent * event);
 static void gst_inter_pipe_ilistener_init (GstInterPipeIListenerInterface *
     iface);
+static void gst_inter_pipe_src_cancel_switch (GstInterPipeSrc * src);
+static void gst_inter_pipe_src_set_cut_buffer (GstInterPipeSrc * src,
+    GstBuffer * buffer);
+static gboolean gst_inter_pipe_src_is_cut_duplicate (GstInterPipeSrc * src,
+    GstBuffer * buffer);
+static GstInterPipeSrcSwitch *gst_inter_pipe_src_switch_new (GstInterPipeSrc *
+    src, gchar * node_name);
+static void gst_inter_pipe_src_switch_task (gpointer data,
+    gpointer user_data);
+static void gst_inter_pipe_src_set_listen_to (GstInterPipeSrc * src,
+    const gchar * node_name);
+static gchar *gst_inter_pipe_src_dup_listen_to (GstInterPipeSrc * src);
+static gboolean gst_inter_pipe_src_is_listen_to (GstInterPipeSrc * src,
+    const gchar * node_name);
+static GstFlowReturn gst_inter_pipe_src_deliver (GstInterPipeSrc * src,
+    GstMiniObject * data, GstClockTimeDiff offset);
+static void gst_inter_pipe_src_apply_offset (GstInterPipeSrc * src);
+static void gst_inter_pipe_src_clear_offsets (GstInterPipeSrc * src);
+static guint gst_inter_pipe_src_data_size (GstMiniObject * data);
+static gboolean gst_inter_pipe_src_ring_can_skip_accounting (GstInterPipeSrc *
+    src);
+static gboolean gst_inter_pipe_src_queue_is_full (GstInterPipeSrc * src,
+    guint factor);
+static void gst_inter_pipe_src_prepare_switch (GstInterPipeSrc * src,
+    gboolean hold);
+static void gst_inter_pipe_src_release_switch (GstInterPipeSrc * src,
+    gboolean commit);
+static void gst_inter_pipe_src_queue_event (GstInterPipeSrc * src,
+    GstEvent * event);
+static gboolean gst_inter_pipe_src_park (GstInterPipeSrc * src, gboolean eos);
+static gboolean gst_inter_pipe_src_yield (GstInterPipeSrc * src);
+static gboolean gst_inter_pipe_src_hold_until_due (GstInterPipeSrc * src,
+    GstBuffer * buffer);
+static void gst_inter_pipe_src_drop_due (GstInterPipeSrc * src);
+static void gst_inter_pipe_src_park_task (gpointer data, gpointer user_data);
+static void gst_inter_pipe_src_wake (GstInterPipeSrc * src);
+static GstClockTimeDiff gst_inter_pipe_src_rebase_offset (GstInterPipeSrc *
+    src, GstBuffer * buffer);
+static gboolean gst_inter_pipe_src_is_late (GstInterPipeSrc * src,
+    GstBuffer * buffer);
+static gboolean gst_inter_pipe_src_unlock (GstBaseSrc * base);
+static gboolean gst_inter_pipe_src_unlock_stop (GstBaseSrc * base);
+static gboolean gst_inter_pipe_src_do_seek (GstBaseSrc * base,
+    GstSegment * segment);
+static void gst_inter_pipe_src_queue_flushed (GstInterPipeSrc * src);
+
+typedef struct _GstInterPipeSrcRing GstInterPipeSrcRing;
+
+static GstInterPipeSrcRing *gst_inter_pipe_src_ring_new (guint size);
+static void gst_inter_pipe_src_ring_free (GstInterPipeSrcRing * ring);
+static guint gst_inter_pipe_src_ring_get_capacity (GstInterPipeSrcRing *
+    ring);
+static void gst_inter_pipe_src_ring_push (GstInterPipeSrcRing * ring,
+    GstMiniObject * item);
+static GstMiniObject *gst_inter_pipe_src_ring_pop (GstInterPipeSrcRing * ring);
+static gboolean gst_inter_pipe_src_ring_is_empty (GstInterPipeSrcRing * ring);
+static void gst_inter_pipe_src_ring_set_flushing (GstInterPipeSrcRing * ring,
+    gboolean flushing);
+static void gst_inter_pipe_src_ring_clear (GstInterPipeSrcRing * ring);
 
 
 typedef enum
 {
   GST_INTER_PIPE_SRC_RESTART_TIMESTAMP,
   GST_INTER_PIPE_SRC_PASSTHROUGH_TIMESTAMP,
-  GST_INTER_PIPE_SRC_COMPENSATE_TIMESTAMP
+  GST_INTER_PIPE_SRC_COMPENSATE_TIMESTAMP,
+  GST_INTER_PIPE_SRC_COMPENSATE_RUNNING_TIME,
+  GST_INTER_PIPE_SRC_REBASE_TIMESTAMP
 } GstInterPipeSrcStreamSync;
 
 
@@ -115,6 +225,12 @@ gst_inter_pipe_src_stream_sync_get_type (void)
         "passthrough-ts"},
     {GST_INTER_PIPE_SRC_COMPENSATE_TIMESTAMP, "Compensate Timestamp",
         "compensate-ts"},
+    {GST_INTER_PIPE_SRC_COMPENSATE_RUNNING_TIME,
+          "Compensate the running time through the pad offset, leaving the "
+          "timestamps untouched", "compensate-rt"},
+    {GST_INTER_PIPE_SRC_REBASE_TIMESTAMP,
+          "Rebase the timestamps so the first buffer of each node starts at "
+          "the current running time", "rebase-ts"},
     {0, NULL, NULL}
   };
   if (!inter_pipe_src_stream_sync_type) {
@@ -124,18 +240,183 @@ gst_inter_pipe_src_stream_sync_get_type (void)
   return inter_pipe_src_stream_sync_type;
 }
 
+typedef enum
+{
+  GST_INTER_PIPE_SRC_SWITCH_IMMEDIATE,
+  GST_INTER_PIPE_SRC_SWITCH_KEYFRAME
+} GstInterPipeSrcSwitchMode;
+
+#define GST_TYPE_INTER_PIPE_SRC_SWITCH_MODE (gst_inter_pipe_src_switch_mode_get_type ())
+static GType
+gst_inter_pipe_src_switch_mode_get_type (void)
+{
+  static GType inter_pipe_src_switch_mode_type = 0;
+  static const GEnumValue switch_mode_types[] = {
+    {GST_INTER_PIPE_SRC_SWITCH_IMMEDIATE, "Switch on the next buffer",
+        "immediate"},
+    {GST_INTER_PIPE_SRC_SWITCH_KEYFRAME,
+        "Keep the current node until the new one delivers a keyframe",
+        "keyframe"},
+    {0, NULL, NULL}
+  };
+  if (!inter_pipe_src_switch_mode_type) {
+    inter_pipe_src_switch_mode_type =
+        g_enum_register_static ("GstInterPipeSrcSwitchMode", switch_mode_types);
+  }
+  return inter_pipe_src_switch_mode_type;
+}
+
+typedef enum
+{
+  GST_INTER_PIPE_SRC_TRANSPORT_APPSRC,
+  GST_INTER_PIPE_SRC_TRANSPORT_RING
+} GstInterPipeSrcTransport;
+
+#define GST_TYPE_INTER_PIPE_SRC_TRANSPORT (gst_inter_pipe_src_transport_get_type ())
+static GType
+gst_inter_pipe_src_transport_get_type (void)
+{
+  static GType inter_pipe_src_transport_type = 0;
+  static const GEnumValue transport_types[] = {
+    {GST_INTER_PIPE_SRC_TRANSPORT_APPSRC, "The appsrc queue", "appsrc"},
+    {GST_INTER_PIPE_SRC_TRANSPORT_RING, "A lock-free ring", "ring"},
+    {0, NULL, NULL}
+  };
+  if (!inter_pipe_src_transport_type) {
+    inter_pipe_src_transport_type =
+        g_enum_register_static ("GstInterPipeSrcTransport", transport_types);
+  }
+  return inter_pipe_src_transport_type;
+}
+
+typedef enum
+{
+  GST_INTER_PIPE_SRC_LEAKY_NO,
+  GST_INTER_PIPE_SRC_LEAKY_UPSTREAM,
+  GST_INTER_PIPE_SRC_LEAKY_DOWNSTREAM
+} GstInterPipeSrcLeaky;
+
+#define GST_TYPE_INTER_PIPE_SRC_LEAKY (gst_inter_pipe_src_leaky_get_type ())
+static GType
+gst_inter_pipe_src_leaky_get_type (void)
+{
+  static GType inter_pipe_src_leaky_type = 0;
+  static const GEnumValue leaky_types[] = {
+    {GST_INTER_PIPE_SRC_LEAKY_NO, "Not Leaky, block the node", "no"},
+    {GST_INTER_PIPE_SRC_LEAKY_UPSTREAM, "Leaky on upstream (new buffers)",
+        "upstream"},
+    {GST_INTER_PIPE_SRC_LEAKY_DOWNSTREAM,
+        "Leaky on downstream (old buffers)", "downstream"},
+    {0, NULL, NULL}
+  };
+  if (!inter_pipe_src_leaky_type) {
+    inter_pipe_src_leaky_type =
+        g_enum_register_static ("GstInterPipeSrcLeaky", leaky_types);
+  }
+  return inter_pipe_src_leaky_type;
+}
+
+/* A pad offset waiting for the items queued before it */
+typedef struct
+{
+  guint ahead;
+  GstClockTimeDiff offset;
+} GstInterPipeSrcOffsetChange;
+
+/* A ring slot. Its sequence number tells whose turn it is: equal to
+ * the write index a producer may claim it, one past it the item is
+ * published for the consumer */
+typedef struct
+{
+  GstMiniObject *item;
+  gint seq;
+} GstInterPipeSrcRingSlot;
+
+/* Bounded ring between the node threads (producers) and the streaming
+ * thread (consumer). Indices grow freely and are masked on access.
+ * Producers claim a slot with a compare and swap on the tail, so the two
+ * nodes overlapping during a switch don't need a lock either. Wakeups
+ * work like an eventfd: the producer only signals the consumer when it
+ * went to sleep on an empty ring, so a busy consumer costs no futex
+ * calls. Items that don't fit wait in the overflow list, nothing is
+ * dropped */
+struct _GstInterPipeSrcRing
+{
+  GstInterPipeSrcRingSlot *slots;
+  guint mask;
+
+  /* Next slot to read, only written by the consumer */
+  gint head;
+  /* Next slot to claim */
+  gint tail;
+
+  /* Items behind a full ring, protected by overflow_lock. Their count
+   * is mirrored in overflowing for the others to check without it */
+  GQueue overflow;
+  gint overflowing;
+  GMutex overflow_lock;
+
+  gint waiting;
+  gint flushing;
+
+  GMutex wait_lock;
+  GCond wait_cond;
+};
+
+/* While a keyframe switch is pending, this listener is attached to the
+ * new node on behalf of the source, drops its delta units and performs
+ * the switch on the first keyframe */
+#define GST_TYPE_INTER_PIPE_SRC_PROXY (gst_inter_pipe_src_proxy_get_type ())
+#define GST_INTER_PIPE_SRC_PROXY(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+    GST_TYPE_INTER_PIPE_SRC_PROXY, GstInterPipeSrcProxy))
+
+typedef struct _GstInterPipeSrcProxy GstInterPipeSrcProxy;
+typedef struct _GstInterPipeSrcProxyClass GstInterPipeSrcProxyClass;
+
+struct _GstInterPipeSrcProxy
+{
+  GObject parent;
+
+  GstInterPipeSrc *src;
+  gchar *name;
+  gchar *node;
+
+  /* The thread attaching the proxy, and a keyframe it saw meanwhile */
+  GThread *attach_thread;
+  gboolean cut_pending;
+};
+
+struct _GstInterPipeSrcProxyClass
+{
+  GObjectClass parent_class;
+};
+
+static GType gst_inter_pipe_src_proxy_get_type (void);
+static void gst_inter_pipe_src_proxy_ilistener_init
+    (GstInterPipeIListenerInterface * iface);
+static gboolean gst_inter_pipe_src_cut_over (GstInterPipeSrc * src,
+    GstInterPipeSrcProxy * proxy, GstBuffer * buffer);
+
 struct _GstInterPipeSrc
 {
   GstAppSrc parent;
 
-  /* Name of the node to listen to */
+  /* Name of the node to listen to, protected by the object lock */
   gchar *listen_to;
 
   /* Currently started and listening */
   gboolean listening;
 
-  /* Pending serial events queue */
+  /* The node the source is attached to, set by the core so upstream
+   * events reach it without looking the name up */
+  GWeakRef node;
+
+  /* Pending serial events ordered by timestamp, protected by
+   * direct_lock */
   GQueue *pending_serial_events;
+  /* Their count, updated atomically so the streaming thread only takes
+   * the lock when there are any */
+  gint pending_events;
 
   /* Block switch */
   gboolean block_switch;
@@ -154,17 +435,140 @@ struct _GstInterPipeSrc
 
   /* Accept end of stream event */
   gboolean accept_eos_event;
+
+  /* Node to switch to at switch_time, protected by the object lock.
+   * switch_to is also set atomically so the data flow can tell whether
+   * a switch is pending without taking the lock */
+  gchar *switch_to;
+  GstClockTime switch_time;
+  /* Set while a scheduled switch waits for the switcher, which clears
+   * it with switch_lock held */
+  gboolean switch_due;
+  GMutex switch_lock;
+
+  /* How to switch between nodes */
+  GstInterPipeSrcSwitchMode switch_mode;
+
+  /* Pending keyframe switch, protected by the object lock */
+  GstInterPipeSrcProxy *switch_proxy;
+  /* The keyframe that completed it, which the node may replay too, and
+   * whether one copy already went through. Protected by the object lock */
+  GstBuffer *cut_buffer;
+  gboolean cut_seen;
+
+  /* Push from the node's thread while the streaming thread is idle */
+  gboolean direct_push;
+
+  /* Protects the streaming thread state below */
+  GMutex direct_lock;
+
+  /* Items waiting in the appsrc queue or the ring */
+  guint queued;
+
+  /* Queueing policy, limits of 0 mean unlimited */
+  guint queue_max_buffers;
+  guint queue_max_bytes;
+  GstClockTime queue_max_time;
+  GstInterPipeSrcLeaky queue_leaky;
+
+  /* Bytes in the ring, updated atomically. appsrc keeps its own count */
+  gint queued_bytes;
+  /* Timestamps of the newest queued and the last dequeued buffer */
+  GstClockTime queued_in_ts;
+  GstClockTime queued_out_ts;
+  /* Set while the streaming thread is being unlocked */
+  gboolean queue_flushing;
+  /* Signaled when the streaming thread dequeues */
+  GCond queue_cond;
+
+  /* Drop what the previous node left queued when switching */
+  gboolean flush_on_switch;
+  /* Queued buffers and pending events the streaming thread drops */
+  guint stale_buffers;
+  guint stale_events;
+  /* While a batch switch may still be rolled back, the last held_stale
+   * marks belong to it and their items still go downstream */
+  gboolean switch_held;
+  guint held_stale_buffers;
+  guint held_stale_events;
+  gint held_rebase;
+
+  /* Running time offset on the pad, set by the thread that pushes */
+  GstClockTimeDiff pad_offset;
+  /* Offset of the newest queued item */
+  GstClockTimeDiff queued_offset;
+  /* Offsets that take over once the items ahead of them are dequeued */
+  GQueue offset_changes;
+
+  /* Offset of the rebase-ts mode, computed again on the first buffer
+   * after a switch */
+  gint rebase_pending;
+  GstClockTimeDiff rebase_offset;
+
+  /* Drop buffers dequeued later than this, -1 disables it */
+  gint64 max_lateness;
+  guint64 dropped_late;
+
+  /* The streaming thread is pushing a dequeued item */
+  gboolean task_busy;
+
+  /* Caps and segment are already downstream */
+  gboolean direct_ready;
+  /* A node thread is pushing downstream without direct_lock, the
+   * streaming thread waits for it on queue_cond */
+  gboolean direct_pushing;
+
+  /* How buffers travel to the streaming thread */
+  GstInterPipeSrcTransport transport;
+  guint ring_size;
+
+  /* Ring used while started with the ring transport, read atomically
+   * by the node threads */
+  GstInterPipeSrcRing *ring;
+  /* Rings outgrown on a restart, a late node thread may still push
+   * into them so they are only freed along with the source */
+  GSList *retired_rings;
+  gboolean ring_active;
+  /* Nothing in use needs the queue accounting, so buffers go through
+   * the ring without direct_lock. Decided when the source starts */
+  gboolean ring_lockless;
+
+  /* Run the streaming task on the shared task pool */
+  gboolean shared_task;
+  gboolean shared_task_active;
+  gboolean task_in_pool;
+  /* The streaming task returned instead of waiting for data and EOS
+   * was already queued, protected by direct_lock */
+  gboolean parked;
+  gboolean eos_queued;
+  /* Parked with data queued, to let the waiting tasks have the thread
+   * or until due_buffer is due on the clock. The parker starts the task
+   * again once resume is set. Protected by direct_lock */
+  gboolean yielded;
+  gboolean resume;
+  GstBuffer *due_buffer;
+  GstClockID due_clock_id;
+  /* Items taken since the last look at the pool, streaming thread only */
+  guint task_slice;
 };
 
 struct _GstInterPipeSrcClass
 {
   GstAppSrcClass parent_class;
+
+  /* actions */
+  gboolean (*schedule_switch) (GstInterPipeSrc * src, const gchar * node_name,
+      guint64 running_time);
 };
 
 G_DEFINE_TYPE_WITH_CODE (GstInterPipeSrc, gst_inter_pipe_src, GST_TYPE_APP_SRC,
     G_IMPLEMENT_INTERFACE (GST_INTER_PIPE_TYPE_ILISTENER,
         gst_inter_pipe_ilistener_init));
 
+G_DEFINE_TYPE_WITH_CODE (GstInterPipeSrcProxy, gst_inter_pipe_src_proxy,
+    G_TYPE_OBJECT, G_IMPLEMENT_INTERFACE (GST_INTER_PIPE_TYPE_ILISTENER,
+        gst_inter_pipe_src_proxy_ilistener_init));
+
 static void
 gst_inter_pipe_src_class_init (GstInterPipeSrcClass * klass)
 {
@@ -222,10 +626,140 @@ gst_inter_pipe_src_class_init (GstInterPipeSrcClass * klass)
           "Accept the EOS event received from the interpipesink only if it "
           "is set to true", TRUE, G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_SWITCH_MODE,
+      g_param_spec_enum ("switch-mode", "Switch Mode",
+          "When to cut over to a new node while listening to another one. "
+          "Keyframe mode is meant for encoded streams, the source keeps "
+          "the current node until the new one delivers a buffer that is "
+          "not a delta unit",
+          GST_TYPE_INTER_PIPE_SRC_SWITCH_MODE,
+          GST_INTER_PIPE_SRC_SWITCH_IMMEDIATE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DIRECT_PUSH,
+      g_param_spec_boolean ("direct-push", "Direct Push",
+          "Push buffers downstream from the thread of the node while PLAYING "
+          "and the streaming thread has nothing left to push, saving a "
+          "thread handoff per buffer. The node blocks while downstream "
+          "processes the buffer. Buffers are queued as usual otherwise",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TRANSPORT,
+      g_param_spec_enum ("transport", "Transport",
+          "How buffers are handed from the node to the streaming thread. "
+          "The ring avoids the appsrc queue lock and only wakes up the "
+          "streaming thread when it is waiting. Without direct-push, "
+          "flush-on-switch, shared-task, queue limits or a stream-sync mode "
+          "that shifts the running time, neither side takes a lock per "
+          "buffer unless the ring overflows. "
+          "Applied when the source starts", GST_TYPE_INTER_PIPE_SRC_TRANSPORT,
+          GST_INTER_PIPE_SRC_TRANSPORT_APPSRC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_RING_SIZE,
+      g_param_spec_uint ("ring-size", "Ring Size",
+          "Number of buffers the ring transport holds, rounded up to a power "
+          "of two. Buffers arriving while the ring is full wait behind it "
+          "in a locked list, none is dropped. Applied when the source starts",
+          2, G_MAXINT / 2,
+          DEFAULT_RING_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_QUEUE_MAX_BUFFERS,
+      g_param_spec_uint ("queue-max-buffers", "Queue Max Buffers",
+          "Maximum number of buffers waiting for the streaming thread "
+          "(0 = unlimited)", 0, G_MAXUINT, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_QUEUE_MAX_BYTES,
+      g_param_spec_uint ("queue-max-bytes", "Queue Max Bytes",
+          "Maximum number of bytes waiting for the streaming thread "
+          "(0 = unlimited). Unlike the appsrc max-bytes it is enforced "
+          "according to queue-leaky", 0, G_MAXUINT, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_QUEUE_MAX_TIME,
+      g_param_spec_uint64 ("queue-max-time", "Queue Max Time",
+          "Maximum amount of time in ns waiting for the streaming thread, "
+          "measured on the buffer timestamps (0 = unlimited)", 0,
+          G_MAXUINT64, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_QUEUE_LEAKY,
+      g_param_spec_enum ("queue-leaky", "Queue Leaky",
+          "What to do when a queue limit is reached: block the node until "
+          "the streaming thread catches up, drop the new buffers, or drop "
+          "the oldest ones as they are dequeued. In the later case new "
+          "buffers are dropped as well once twice the limit is queued",
+          GST_TYPE_INTER_PIPE_SRC_LEAKY, GST_INTER_PIPE_SRC_LEAKY_NO,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FLUSH_ON_SWITCH,
+      g_param_spec_boolean ("flush-on-switch", "Flush On Switch",
+          "Drop the buffers and serialized events still queued from the "
+          "previous node when switching, so the first buffer pushed after "
+          "the switch comes from the new node", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_LATENESS,
+      g_param_spec_int64 ("max-lateness", "Max Lateness",
+          "Drop the buffers whose running time is behind the clock by more "
+          "than this many ns when the streaming thread dequeues them, so a "
+          "stall does not add latency for good (-1 = disabled). Only "
+          "applies while PLAYING", -1, G_MAXINT64, -1,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DROPPED_LATE,
+      g_param_spec_uint64 ("dropped-late", "Dropped Late",
+          "Number of buffers dropped because of max-lateness", 0,
+          G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SHARED_TASK,
+      g_param_spec_boolean ("shared-task", "Shared Task",
+          "Run the streaming task on a pool shared by all the interpipesrcs "
+          "with one thread per core. The task gives its thread back while "
+          "nothing is queued and, when live, while its next buffer isn't due "
+          "yet. A busy task hands its thread over every few buffers while "
+          "others wait for one. A push blocked downstream for another reason "
+          "keeps the thread until it returns. Applied when the source starts",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterPipeSrc::schedule-switch:
+   * @src: the interpipesrc
+   * @node_name: the node to switch to, or NULL to cancel a pending switch
+   * @running_time: the running time to switch at
+   *
+   * Keep listening to the current node until its first buffer at or
+   * after @running_time and switch to @node_name on that buffer, which
+   * is still pushed. Sources in the same pipeline scheduled with the
+   * same running time switch on the same timestamp. A new schedule
+   * replaces the pending one. The switch runs off the node's streaming
+   * thread; until it is done the later buffers of the current node are
+   * dropped.
+   *
+   * Returns: TRUE if the switch was scheduled.
+   */
+  gst_inter_pipe_src_signals[SIGNAL_SCHEDULE_SWITCH] =
+      g_signal_new ("schedule-switch", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstInterPipeSrcClass,
+          schedule_switch), NULL, NULL, NULL, G_TYPE_BOOLEAN, 2, G_TYPE_STRING,
+      G_TYPE_UINT64);
+
+  klass->schedule_switch = gst_inter_pipe_src_schedule_switch;
+
+  gst_inter_pipe_src_parker =
+      g_thread_pool_new (gst_inter_pipe_src_park_task, NULL, 1, FALSE, NULL);
+  gst_inter_pipe_src_switcher =
+      g_thread_pool_new (gst_inter_pipe_src_switch_task, NULL,
+      MAX (g_get_num_processors (), 1), FALSE, NULL);
+
   basesrc_class->start = GST_DEBUG_FUNCPTR (gst_inter_pipe_src_start);
   basesrc_class->stop = GST_DEBUG_FUNCPTR (gst_inter_pipe_src_stop);
   basesrc_class->event = GST_DEBUG_FUNCPTR (gst_inter_pipe_src_event);
   basesrc_class->create = GST_DEBUG_FUNCPTR (gst_inter_pipe_src_create);
+  basesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_inter_pipe_src_unlock);
+  basesrc_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_inter_pipe_src_unlock_stop);
+  basesrc_class->do_seek = GST_DEBUG_FUNCPTR (gst_inter_pipe_src_do_seek);
 }
 
 static void
@@ -235,13 +769,68 @@ gst_inter_pipe_src_init (GstInterPipeSrc * src)
 
   src->listen_to = NULL;
   src->listening = FALSE;
+  g_weak_ref_init (&src->node, NULL);
   src->pending_serial_events = g_queue_new ();
+  src->pending_events = 0;
   src->block_switch = FALSE;
   src->allow_renegotiation = TRUE;
   src->first_switch = TRUE;
   src->stream_sync = GST_INTER_PIPE_SRC_PASSTHROUGH_TIMESTAMP;
   src->accept_events = TRUE;
   src->accept_eos_event = TRUE;
+  src->switch_to = NULL;
+  src->switch_time = GST_CLOCK_TIME_NONE;
+  src->switch_due = FALSE;
+  g_mutex_init (&src->switch_lock);
+  src->switch_mode = GST_INTER_PIPE_SRC_SWITCH_IMMEDIATE;
+  src->switch_proxy = NULL;
+  src->cut_buffer = NULL;
+  src->cut_seen = FALSE;
+  src->direct_push = FALSE;
+  src->queued = 0;
+  src->task_busy = FALSE;
+  src->direct_ready = FALSE;
+  src->direct_pushing = FALSE;
+  g_mutex_init (&src->direct_lock);
+  src->transport = GST_INTER_PIPE_SRC_TRANSPORT_APPSRC;
+  src->ring_size = DEFAULT_RING_SIZE;
+  src->ring = NULL;
+  src->retired_rings = NULL;
+  src->ring_active = FALSE;
+  src->ring_lockless = FALSE;
+  src->queue_max_buffers = 0;
+  src->queue_max_bytes = 0;
+  src->queue_max_time = 0;
+  src->queue_leaky = GST_INTER_PIPE_SRC_LEAKY_NO;
+  src->queued_bytes = 0;
+  src->queued_in_ts = GST_CLOCK_TIME_NONE;
+  src->queued_out_ts = GST_CLOCK_TIME_NONE;
+  src->queue_flushing = FALSE;
+  g_cond_init (&src->queue_cond);
+  src->flush_on_switch = FALSE;
+  src->stale_buffers = 0;
+  src->stale_events = 0;
+  src->switch_held = FALSE;
+  src->held_stale_buffers = 0;
+  src->held_stale_events = 0;
+  src->held_rebase = FALSE;
+  src->pad_offset = 0;
+  src->queued_offset = 0;
+  g_queue_init (&src->offset_changes);
+  src->rebase_pending = TRUE;
+  src->rebase_offset = 0;
+  src->max_lateness = -1;
+  src->dropped_late = 0;
+  src->shared_task = FALSE;
+  src->shared_task_active = FALSE;
+  src->task_in_pool = FALSE;
+  src->parked = FALSE;
+  src->yielded = FALSE;
+  src->resume = FALSE;
+  src->due_buffer = NULL;
+  src->due_clock_id = NULL;
+  src->task_slice = 0;
+  src->eos_queued = FALSE;
 }
 
 static void
@@ -250,7 +839,7 @@ gst_inter_pipe_src_set_property (GObject * object, guint prop_id,
 {
   GstInterPipeSrc *src;
   GstInterPipeIListener *listener;
-  gchar *node_name;
+  const gchar *node_name;
 
   g_return_if_fail (GST_IS_INTER_PIPE_SRC (object));
 
@@ -259,44 +848,33 @@ gst_inter_pipe_src_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_LISTEN_TO:
-      node_name = g_strdup (g_value_get_string (value));
-      if (!g_strcmp0 (src->listen_to, node_name)) {
+      node_name = g_value_get_string (value);
+      if (gst_inter_pipe_src_is_listen_to (src, node_name)) {
         /* We are already listening to that node, so nothing to do */
         GST_INFO ("Already listening to node %s", node_name);
-        g_free (node_name);
       } else if (node_name != NULL) {
         if (GST_BASE_SRC_IS_STARTED (GST_BASE_SRC (src))) {
           /* valid node_name, BaseSrc started */
-          if (!gst_inter_pipe_src_listen_node (src, node_name)) {
+          if (!gst_inter_pipe_src_listen_node (src, node_name, NULL)) {
             GST_ERROR_OBJECT (src, "Could not listen to node %s", node_name);
-            g_free (node_name);
           } else {
-            if (src->listen_to) {
-              g_free (src->listen_to);
-            }
-            src->listen_to = node_name;
+            gst_inter_pipe_src_set_listen_to (src, node_name);
+            GST_INFO_OBJECT (src, "Listening to node %s", node_name);
           }
           src->listening = TRUE;
-          GST_INFO_OBJECT (src, "Listening to node %s", src->listen_to);
         } else {
           /* valid node_name, not started */
-          g_free (src->listen_to);
-          src->listen_to = node_name;
+          gst_inter_pipe_src_set_listen_to (src, node_name);
         }
       } else {
+        gst_inter_pipe_src_cancel_switch (src);
         if (src->listening) {
           /* NULL node name, currently listening */
           if (!gst_inter_pipe_leave_node (listener))
-            GST_WARNING_OBJECT (src, "Unable to remove listener from node %s",
-                src->listen_to);
-          g_free (src->listen_to);
-          src->listen_to = NULL;
+            GST_WARNING_OBJECT (src, "Unable to remove listener from its node");
           src->listening = FALSE;
-        } else {
-          /* NULL node name, not listening/started */
-          g_free (src->listen_to);
-          src->listen_to = NULL;
         }
+        gst_inter_pipe_src_set_listen_to (src, NULL);
       }
       break;
     case PROP_BLOCK_SWITCH:
@@ -314,6 +892,51 @@ gst_inter_pipe_src_set_property (GObject * object, guint prop_id,
     case PROP_ACCEPT_EOS_EVENT:
       src->accept_eos_event = g_value_get_boolean (value);
       break;
+    case PROP_SWITCH_MODE:
+      src->switch_mode = g_value_get_enum (value);
+      break;
+    case PROP_DIRECT_PUSH:
+      src->direct_push = g_value_get_boolean (value);
+      break;
+    case PROP_TRANSPORT:
+      src->transport = g_value_get_enum (value);
+      break;
+    case PROP_RING_SIZE:
+      src->ring_size = g_value_get_uint (value);
+      break;
+    case PROP_QUEUE_MAX_BUFFERS:
+      g_mutex_lock (&src->direct_lock);
+      src->queue_max_buffers = g_value_get_uint (value);
+      g_cond_broadcast (&src->queue_cond);
+      g_mutex_unlock (&src->direct_lock);
+      break;
+    case PROP_QUEUE_MAX_BYTES:
+      g_mutex_lock (&src->direct_lock);
+      src->queue_max_bytes = g_value_get_uint (value);
+      g_cond_broadcast (&src->queue_cond);
+      g_mutex_unlock (&src->direct_lock);
+      break;
+    case PROP_QUEUE_MAX_TIME:
+      g_mutex_lock (&src->direct_lock);
+      src->queue_max_time = g_value_get_uint64 (value);
+      g_cond_broadcast (&src->queue_cond);
+      g_mutex_unlock (&src->direct_lock);
+      break;
+    case PROP_QUEUE_LEAKY:
+      g_mutex_lock (&src->direct_lock);
+      src->queue_leaky = g_value_get_enum (value);
+      g_cond_broadcast (&src->queue_cond);
+      g_mutex_unlock (&src->direct_lock);
+      break;
+    case PROP_FLUSH_ON_SWITCH:
+      src->flush_on_switch = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_LATENESS:
+      src->max_lateness = g_value_get_int64 (value);
+      break;
+    case PROP_SHARED_TASK:
+      src->shared_task = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -332,7 +955,9 @@ gst_inter_pipe_src_get_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_LISTEN_TO:
+      GST_OBJECT_LOCK (src);
       g_value_set_string (value, src->listen_to);
+      GST_OBJECT_UNLOCK (src);
       break;
     case PROP_BLOCK_SWITCH:
       g_value_set_boolean (value, src->block_switch);
@@ -349,6 +974,44 @@ gst_inter_pipe_src_get_property (GObject * object, guint prop_id,
     case PROP_ACCEPT_EOS_EVENT:
       g_value_set_boolean (value, src->accept_eos_event);
       break;
+    case PROP_SWITCH_MODE:
+      g_value_set_enum (value, src->switch_mode);
+      break;
+    case PROP_DIRECT_PUSH:
+      g_value_set_boolean (value, src->direct_push);
+      break;
+    case PROP_TRANSPORT:
+      g_value_set_enum (value, src->transport);
+      break;
+    case PROP_RING_SIZE:
+      g_value_set_uint (value, src->ring_size);
+      break;
+    case PROP_QUEUE_MAX_BUFFERS:
+      g_value_set_uint (value, src->queue_max_buffers);
+      break;
+    case PROP_QUEUE_MAX_BYTES:
+      g_value_set_uint (value, src->queue_max_bytes);
+      break;
+    case PROP_QUEUE_MAX_TIME:
+      g_value_set_uint64 (value, src->queue_max_time);
+      break;
+    case PROP_QUEUE_LEAKY:
+      g_value_set_enum (value, src->queue_leaky);
+      break;
+    case PROP_FLUSH_ON_SWITCH:
+      g_value_set_boolean (value, src->flush_on_switch);
+      break;
+    case PROP_MAX_LATENESS:
+      g_value_set_int64 (value, src->max_lateness);
+      break;
+    case PROP_DROPPED_LATE:
+      g_mutex_lock (&src->direct_lock);
+      g_value_set_uint64 (value, src->dropped_late);
+      g_mutex_unlock (&src->direct_lock);
+      break;
+    case PROP_SHARED_TASK:
+      g_value_set_boolean (value, src->shared_task);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -366,21 +1029,46 @@ gst_inter_pipe_src_finalize (GObject * object)
   g_queue_free_full (src->pending_serial_events,
       (GDestroyNotify) gst_event_unref);
 
-  if (src->listen_to) {
-    g_free (src->listen_to);
-    src->listen_to = NULL;
-  }
+  g_free (src->listen_to);
+  g_weak_ref_clear (&src->node);
+  g_free (src->switch_to);
+  if (src->cut_buffer)
+    gst_buffer_unref (src->cut_buffer);
+
+  gst_inter_pipe_src_clear_offsets (src);
+  g_mutex_clear (&src->switch_lock);
+  g_mutex_clear (&src->direct_lock);
+  g_cond_clear (&src->queue_cond);
+
+  if (src->ring)
+    gst_inter_pipe_src_ring_free (src->ring);
+  g_slist_free_full (src->retired_rings,
+      (GDestroyNotify) gst_inter_pipe_src_ring_free);
 
   /* Chain up to the parent class */
   G_OBJECT_CLASS (gst_inter_pipe_src_parent_class)->finalize (object);
 }
 
+/* The element's base time without its object lock, so a
+ * gst_element_set_base_time() while PLAYING applies from the next
+ * buffer on. Hosts without atomic 64-bit loads take the lock */
+static GstClockTime
+gst_inter_pipe_src_get_base_time (GstInterPipeSrc * src)
+{
+#if GLIB_SIZEOF_VOID_P == 8
+  return *(volatile GstClockTime *) & GST_ELEMENT_CAST (src)->base_time;
+#else
+  return gst_element_get_base_time (GST_ELEMENT_CAST (src));
+#endif
+}
+
 /* GstBaseSrc Implementation*/
 static gboolean
 gst_inter_pipe_src_start (GstBaseSrc * base)
 {
   GstBaseSrcClass *basesrc_class;
   GstInterPipeSrc *src;
+  gchar *listen_to;
 
   basesrc_class = GST_BASE_SRC_CLASS (gst_inter_pipe_src_parent_class);
   src = GST_INTER_PIPE_SRC (base);
@@ -388,13 +1076,46 @@ gst_inter_pipe_src_start (GstBaseSrc * base)
   if (!basesrc_class->start (base))
     goto start_fail;
 
-  if (src->listen_to) {
-    if (!gst_inter_pipe_src_listen_node (src, src->listen_to)) {
-      GST_ERROR_OBJECT (src, "Could not listen to node %s", src->listen_to);
+  g_atomic_int_set (&src->rebase_pending, TRUE);
+
+  /* A new task is created on every start */
+  src->shared_task_active = src->shared_task;
+  src->task_in_pool = FALSE;
+  src->task_slice = 0;
+  g_mutex_lock (&src->direct_lock);
+  src->parked = FALSE;
+  src->eos_queued = FALSE;
+  gst_inter_pipe_src_drop_due (src);
+  g_mutex_unlock (&src->direct_lock);
+
+  /* The previous ring is kept across restarts, a late buffer from the
+   * last session may still be on its way into it */
+  if (GST_INTER_PIPE_SRC_TRANSPORT_RING == src->transport) {
+    if (src->ring && gst_inter_pipe_src_ring_get_capacity (src->ring) <
+        src->ring_size) {
+      gst_inter_pipe_src_ring_clear (src->ring);
+      src->retired_rings = g_slist_prepend (src->retired_rings, src->ring);
+      g_atomic_pointer_set (&src->ring, NULL);
+    }
+    if (!src->ring)
+      g_atomic_pointer_set (&src->ring,
+          gst_inter_pipe_src_ring_new (src->ring_size));
+    src->ring_active = TRUE;
+  } else {
+    src->ring_active = FALSE;
+  }
+  src->ring_lockless = gst_inter_pipe_src_ring_can_skip_accounting (src);
+
+  listen_to = gst_inter_pipe_src_dup_listen_to (src);
+  if (listen_to) {
+    if (!gst_inter_pipe_src_listen_node (src, listen_to, NULL)) {
+      GST_ERROR_OBJECT (src, "Could not listen to node %s", listen_to);
+      g_free (listen_to);
       goto start_fail;
     } else {
-      GST_INFO_OBJECT (src, "Listening to node %s", src->listen_to);
+      GST_INFO_OBJECT (src, "Listening to node %s", listen_to);
       src->listening = TRUE;
+      g_free (listen_to);
       goto start_done;
     }
   } else {
@@ -417,13 +1138,51 @@ gst_inter_pipe_src_stop (GstBaseSrc * base)
   GstBaseSrcClass *basesrc_class;
   GstInterPipeSrc *src;
   GstInterPipeIListener *listener;
+  gchar *switch_to;
 
   basesrc_class = GST_BASE_SRC_CLASS (gst_inter_pipe_src_parent_class);
   src = GST_INTER_PIPE_SRC (base);
   listener = GST_INTER_PIPE_ILISTENER (src);
 
+  GST_OBJECT_LOCK (src);
+  switch_to = src->switch_to;
+  g_atomic_pointer_set (&src->switch_to, NULL);
+  src->switch_time = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK (src);
+  g_free (switch_to);
+
+  /* Waits for a switch already running on the switcher */
+  g_mutex_lock (&src->switch_lock);
+  g_atomic_int_set (&src->switch_due, FALSE);
+  g_mutex_unlock (&src->switch_lock);
+
+  gst_inter_pipe_src_cancel_switch (src);
+  gst_inter_pipe_src_set_cut_buffer (src, NULL);
+
+  g_mutex_lock (&src->direct_lock);
+  src->queued = 0;
+  src->task_busy = FALSE;
+  src->direct_ready = FALSE;
+  g_atomic_int_set (&src->queued_bytes, 0);
+  src->queued_in_ts = GST_CLOCK_TIME_NONE;
+  src->queued_out_ts = GST_CLOCK_TIME_NONE;
+  src->stale_buffers = 0;
+  src->stale_events = 0;
+  src->switch_held = FALSE;
+  src->held_stale_buffers = 0;
+  src->held_stale_events = 0;
+  gst_inter_pipe_src_clear_offsets (src);
+  gst_inter_pipe_src_drop_due (src);
+  g_cond_broadcast (&src->queue_cond);
+  g_mutex_unlock (&src->direct_lock);
+
+  src->ring_active = FALSE;
+  src->ring_lockless = FALSE;
+  if (src->ring)
+    gst_inter_pipe_src_ring_clear (src->ring);
+
   if (src->listening) {
-    GST_INFO_OBJECT (src, "Removing listener from node %s", src->listen_to);
+    GST_INFO_OBJECT (src, "Removing listener from its node");
     gst_inter_pipe_leave_node (listener);
     src->listening = FALSE;
   }
@@ -437,25 +1196,220 @@ gst_inter_pipe_src_event (GstBaseSrc * base, GstEvent * event)
   GstBaseSrcClass *basesrc_class;
   GstInterPipeSrc *src;
   GstInterPipeINode *node;
+  gboolean ret;
 
   basesrc_class = GST_BASE_SRC_CLASS (gst_inter_pipe_src_parent_class);
   src = GST_INTER_PIPE_SRC (base);
-  node = gst_inter_pipe_get_node (src->listen_to);
 
   if (GST_EVENT_IS_UPSTREAM (event)) {
 
     GST_INFO_OBJECT (src, "Incoming upstream event %s",
         GST_EVENT_TYPE_NAME (event));
 
+    node = g_weak_ref_get (&src->node);
     if (node) {
       gst_inter_pipe_inode_receive_event (node, gst_event_ref (event));
+      g_object_unref (node);
     } else
       GST_WARNING_OBJECT (src, "Node doesn't exist, event won't be forwarded");
   }
 
+  /* appsrc drops its queue on FLUSH_STOP */
+  if (GST_EVENT_FLUSH_STOP == GST_EVENT_TYPE (event)) {
+    ret = basesrc_class->event (base, event);
+    gst_inter_pipe_src_queue_flushed (src);
+    return ret;
+  }
+
   return basesrc_class->event (base, event);
 }
 
+/* appsrc drops its queue after a successful seek */
+static gboolean
+gst_inter_pipe_src_do_seek (GstBaseSrc * base, GstSegment * segment)
+{
+  GstInterPipeSrc *src;
+
+  src = GST_INTER_PIPE_SRC (base);
+
+  if (!GST_BASE_SRC_CLASS (gst_inter_pipe_src_parent_class)->do_seek (base,
+          segment))
+    return FALSE;
+
+  gst_inter_pipe_src_queue_flushed (src);
+
+  return TRUE;
+}
+
+/* Forget what appsrc had queued. The ring transport keeps its items
+ * across flushes, along with their accounting */
+static void
+gst_inter_pipe_src_queue_flushed (GstInterPipeSrc * src)
+{
+  GstInterPipeSrcOffsetChange *change;
+
+  if (src->ring_active)
+    return;
+
+  g_mutex_lock (&src->direct_lock);
+  GST_DEBUG_OBJECT (src, "Queue flushed, %u buffers dropped", src->queued);
+  src->queued = 0;
+  g_atomic_int_set (&src->queued_bytes, 0);
+  src->queued_in_ts = GST_CLOCK_TIME_NONE;
+  src->queued_out_ts = GST_CLOCK_TIME_NONE;
+  src->stale_buffers = 0;
+  src->held_stale_buffers = 0;
+
+  /* The offset changes waiting for the flushed items are due now */
+  while ((change = g_queue_pop_head (&src->offset_changes)))
+    g_free (change);
+  if (src->queued_offset != src->pad_offset) {
+    gst_pad_set_offset (GST_INTER_PIPE_SRC_PAD (src), src->queued_offset);
+    src->pad_offset = src->queued_offset;
+  }
+
+  /* Release the nodes waiting for room */
+  g_cond_broadcast (&src->queue_cond);
+  g_mutex_unlock (&src->direct_lock);
+}
+
+static gboolean
+gst_inter_pipe_src_unlock (GstBaseSrc * base)
+{
+  GstInterPipeSrc *src;
+
+  src = GST_INTER_PIPE_SRC (base);
+
+  if (src->ring)
+    gst_inter_pipe_src_ring_set_flushing (src->ring, TRUE);
+
+  /* Release a node waiting for room in the queue */
+  g_mutex_lock (&src->direct_lock);
+  src->queue_flushing = TRUE;
+  g_cond_broadcast (&src->queue_cond);
+  g_mutex_unlock (&src->direct_lock);
+
+  return GST_BASE_SRC_CLASS (gst_inter_pipe_src_parent_class)->unlock (base);
+}
+
+static gboolean
+gst_inter_pipe_src_unlock_stop (GstBaseSrc * base)
+{
+  GstInterPipeSrc *src;
+
+  src = GST_INTER_PIPE_SRC (base);
+
+  if (src->ring)
+    gst_inter_pipe_src_ring_set_flushing (src->ring, FALSE);
+
+  /* A flush clears the EOS queued in appsrc, and the buffer held */
+  g_mutex_lock (&src->direct_lock);
+  src->queue_flushing = FALSE;
+  src->eos_queued = FALSE;
+  gst_inter_pipe_src_drop_due (src);
+  g_mutex_unlock (&src->direct_lock);
+
+  return GST_BASE_SRC_CLASS (gst_inter_pipe_src_parent_class)->unlock_stop
+      (base);
+}
+
+static gboolean
+gst_inter_pipe_src_is_late (GstInterPipeSrc * src, GstBuffer * buffer)
+{
+  GstSegment *segment;
+  GstClock *clock;
+  GstClockTime running_time;
+  GstClockTime now;
+  gint64 max_lateness;
+
+  max_lateness = src->max_lateness;
+  if (max_lateness < 0 || GST_STATE (src) != GST_STATE_PLAYING)
+    return FALSE;
+
+  running_time = GST_BUFFER_PTS (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return FALSE;
+  running_time += src->pad_offset;
+
+  /* Without a time segment the timestamps are taken as running time */
+  segment = &GST_BASE_SRC (src)->segment;
+  if (GST_FORMAT_TIME == segment->format)
+    running_time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+        running_time);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return FALSE;
+
+  clock = gst_element_get_clock (GST_ELEMENT (src));
+  if (!clock)
+    return FALSE;
+  now = gst_clock_get_time (clock);
+  gst_object_unref (clock);
+
+  now -= MIN (now, gst_inter_pipe_src_get_base_time (src));
+  if (now <= running_time + max_lateness)
+    return FALSE;
+
+  GST_DEBUG_OBJECT (src, "Dropping buffer %p, %" GST_TIME_FORMAT
+      " late", buffer, GST_TIME_ARGS (now - running_time));
+
+  return TRUE;
+}
+
+/* The queue accounting only serves direct pushes, the queue limits,
+ * stale marks, parking on the shared pool and pad offset changes */
+static gboolean
+gst_inter_pipe_src_ring_can_skip_accounting (GstInterPipeSrc * src)
+{
+  return src->ring_active && !src->direct_push && !src->shared_task_active
+      && !src->flush_on_switch && 0 == src->queue_max_buffers
+      && 0 == src->queue_max_bytes && 0 == src->queue_max_time
+      && GST_INTER_PIPE_SRC_COMPENSATE_RUNNING_TIME != src->stream_sync
+      && GST_INTER_PIPE_SRC_REBASE_TIMESTAMP != src->stream_sync;
+}
+
+/* Counterpart of the appsrc create() for the ring transport */
+static GstFlowReturn
+gst_inter_pipe_src_ring_create (GstInterPipeSrc * src, GstBuffer ** buf)
+{
+  GstMiniObject *item;
+
+  while ((item = gst_inter_pipe_src_ring_pop (src->ring))) {
+    if (GST_IS_CAPS (item)) {
+      gboolean caps_set;
+
+      GST_DEBUG_OBJECT (src, "Setting caps %" GST_PTR_FORMAT, item);
+      caps_set = gst_base_src_set_caps (GST_BASE_SRC (src), GST_CAPS (item));
+      gst_caps_unref (GST_CAPS (item));
+      if (!caps_set)
+        return GST_FLOW_NOT_NEGOTIATED;
+      continue;
+    } else if (GST_IS_EVENT (item)) {
+      /* Only EOS travels through the ring */
+      gst_event_unref (GST_EVENT_CAST (item));
+      return GST_FLOW_EOS;
+    }
+
+    /* Only buffers and buffer lists are accounted for */
+    if (!src->ring_lockless)
+      g_atomic_int_add (&src->queued_bytes,
+          -(gint) gst_inter_pipe_src_data_size (item));
+
+#if GST_CHECK_VERSION(1,14,0)
+    if (GST_IS_BUFFER_LIST (item)) {
+      gst_base_src_submit_buffer_list (GST_BASE_SRC (src),
+          GST_BUFFER_LIST_CAST (item));
+      *buf = NULL;
+      return GST_FLOW_OK;
+    }
+#endif
+
+    *buf = GST_BUFFER_CAST (item);
+    return GST_FLOW_OK;
+  }
+
+  return GST_FLOW_FLUSHING;
+}
+
 static GstFlowReturn
 gst_inter_pipe_src_create (GstBaseSrc * base, guint64 offset, guint size,
     GstBuffer ** buf)
@@ -464,47 +1418,176 @@ gst_inter_pipe_src_create (GstBaseSrc * base, guint64 offset, guint size,
   GstEvent *serial_event;
   GstPad *srcpad;
   GstFlowReturn ret;
+  GstClockTime pts;
+  GQueue due = G_QUEUE_INIT;
+  gboolean drained;
+  gboolean late;
 
   src = GST_INTER_PIPE_SRC (base);
   srcpad = GST_INTER_PIPE_SRC_PAD (src);
 
-  ret =
-      GST_BASE_SRC_CLASS (gst_inter_pipe_src_parent_class)->create (base,
-      offset, size, buf);
+  /* Dequeued last time already and due by now. Still busy with it, so
+   * nothing is pushed directly ahead of it */
+  if (G_UNLIKELY (src->due_buffer)) {
+    g_mutex_lock (&src->direct_lock);
+    *buf = src->due_buffer;
+    src->due_buffer = NULL;
+    gst_inter_pipe_src_drop_due (src);
+    g_mutex_unlock (&src->direct_lock);
+    return GST_FLOW_OK;
+  }
+
+  /* Whatever was dequeued last time has been pushed by now */
+  if (!src->ring_lockless) {
+    g_mutex_lock (&src->direct_lock);
+    src->task_busy = FALSE;
+    g_mutex_unlock (&src->direct_lock);
+  }
+
+dequeue:
+  if (src->shared_task_active && (gst_inter_pipe_src_park (src, FALSE)
+          || gst_inter_pipe_src_yield (src)))
+    return GST_FLOW_FLUSHING;
+
+  if (src->ring_active)
+    ret = gst_inter_pipe_src_ring_create (src, buf);
+  else
+    ret =
+        GST_BASE_SRC_CLASS (gst_inter_pipe_src_parent_class)->create (base,
+        offset, size, buf);
 
   if (ret != GST_FLOW_OK) {
     GST_LOG_OBJECT (src, "parent create() returned %s",
         gst_flow_get_name (ret));
+    if (GST_FLOW_EOS == ret && src->shared_task_active)
+      gst_inter_pipe_src_park (src, TRUE);
     return ret;
   }
 
-  GST_LOG_OBJECT (src,
-      "Dequeue buffer %p with timestamp (PTS) %" GST_TIME_FORMAT, *buf,
-      GST_TIME_ARGS (GST_BUFFER_PTS (*buf)));
+  late = *buf && gst_inter_pipe_src_is_late (src, *buf);
 
-  if (!g_queue_is_empty (src->pending_serial_events)) {
-    guint curr_bytes;
-    /*Pending Serial Events Queue */
-    serial_event = g_queue_peek_head (src->pending_serial_events);
+  if (src->ring_lockless) {
+    if (late) {
+      g_mutex_lock (&src->direct_lock);
+      src->dropped_late++;
+      g_mutex_unlock (&src->direct_lock);
+      gst_buffer_unref (*buf);
+      *buf = NULL;
+      goto dequeue;
+    }
+    goto accounted;
+  }
 
-    GST_DEBUG_OBJECT (src,
-        "Got event with timestamp %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (GST_EVENT_TIMESTAMP (serial_event)));
+  g_mutex_lock (&src->direct_lock);
+  /* Don't overtake a direct push, nor change the offset under it */
+  while (src->direct_pushing)
+    g_cond_wait (&src->queue_cond, &src->direct_lock);
+  gst_inter_pipe_src_apply_offset (src);
+  if (src->queued > 0)
+    src->queued--;
+  if (0 == src->queued) {
+    src->queued_in_ts = GST_CLOCK_TIME_NONE;
+    src->queued_out_ts = GST_CLOCK_TIME_NONE;
+  } else if (*buf && GST_BUFFER_DTS_OR_PTS (*buf) != GST_CLOCK_TIME_NONE) {
+    src->queued_out_ts = GST_BUFFER_DTS_OR_PTS (*buf);
+  }
+  g_cond_broadcast (&src->queue_cond);
+
+  /* Queued before a switch, lists are already submitted by now */
+  if (src->stale_buffers > 0) {
+    gboolean held = src->stale_buffers <= src->held_stale_buffers;
+
+    src->stale_buffers--;
+    if (held)
+      src->held_stale_buffers--;
+    if (*buf && !held) {
+      g_mutex_unlock (&src->direct_lock);
+      GST_LOG_OBJECT (src, "Dropping buffer %p from the previous node", *buf);
+      gst_buffer_unref (*buf);
+      *buf = NULL;
+      goto dequeue;
+    }
+  }
+
+  if (late) {
+    src->dropped_late++;
+    g_mutex_unlock (&src->direct_lock);
+    gst_buffer_unref (*buf);
+    *buf = NULL;
+    goto dequeue;
+  }
 
-    curr_bytes = gst_app_src_get_current_level_bytes (GST_APP_SRC (src));
-    if ((GST_EVENT_TIMESTAMP (serial_event) < GST_BUFFER_PTS (*buf))
-        || (curr_bytes == 0)) {
+  /* Leaky downstream drops the oldest buffers, which are the ones
+   * being dequeued, until the queue is back within its limits */
+  if (*buf && GST_INTER_PIPE_SRC_LEAKY_DOWNSTREAM == src->queue_leaky
+      && gst_inter_pipe_src_queue_is_full (src, 1)) {
+    g_mutex_unlock (&src->direct_lock);
+    GST_LOG_OBJECT (src, "Queue full, dropping old buffer %p", *buf);
+    gst_buffer_unref (*buf);
+    *buf = NULL;
+    goto dequeue;
+  }
 
-      GST_DEBUG_OBJECT (src, "Sending Serial Event %s",
-          GST_EVENT_TYPE_NAME (serial_event));
+  /* Caps and segment go downstream along with this item */
+  src->task_busy = TRUE;
+  src->direct_ready = TRUE;
 
-      serial_event = g_queue_pop_head (src->pending_serial_events);
-      gst_pad_push_event (srcpad, serial_event);
-    } else {
-      GST_DEBUG_OBJECT (src, "Event %s timestamp is greater than the "
-          "buffer timestamp, can't send serial event yet",
-          GST_EVENT_TYPE_NAME (serial_event));
+  for (; src->stale_events > src->held_stale_events; src->stale_events--) {
+    serial_event = g_queue_pop_head (src->pending_serial_events);
+    if (!serial_event)
+      break;
+    g_atomic_int_add (&src->pending_events, -1);
+    GST_LOG_OBJECT (src, "Dropping event %s from the previous node",
+        GST_EVENT_TYPE_NAME (serial_event));
+    gst_event_unref (serial_event);
+  }
+  src->stale_events = src->held_stale_events;
+  g_mutex_unlock (&src->direct_lock);
+
+accounted:
+  /* Buffer lists are submitted by appsrc itself and leave no buffer */
+  pts = *buf ? GST_BUFFER_PTS (*buf) : GST_CLOCK_TIME_NONE;
+
+  /* In our timeline, as the events are */
+  if (GST_CLOCK_TIME_IS_VALID (pts))
+    pts += src->pad_offset;
+
+  GST_LOG_OBJECT (src,
+      "Dequeue buffer %p with timestamp (PTS) %" GST_TIME_FORMAT, *buf,
+      GST_TIME_ARGS (pts));
+
+  if (src->ring_active)
+    drained = gst_inter_pipe_src_ring_is_empty (src->ring);
+  else
+    drained = 0 == gst_app_src_get_current_level_bytes (GST_APP_SRC (src));
+
+  /* Release every event due before this buffer in one pass, so a burst
+   * of events doesn't lag behind the data */
+  if (g_atomic_int_get (&src->pending_events) > 0) {
+    g_mutex_lock (&src->direct_lock);
+    while ((serial_event = g_queue_peek_head (src->pending_serial_events))
+        && (drained || GST_EVENT_TIMESTAMP (serial_event) < pts)) {
+      g_queue_push_tail (&due, g_queue_pop_head (src->pending_serial_events));
+      g_atomic_int_add (&src->pending_events, -1);
+      if (src->held_stale_events > 0) {
+        src->held_stale_events--;
+        src->stale_events--;
+      }
     }
+    g_mutex_unlock (&src->direct_lock);
+  }
+
+  while ((serial_event = g_queue_pop_head (&due))) {
+    GST_DEBUG_OBJECT (src, "Sending Serial Event %s with timestamp %"
+        GST_TIME_FORMAT, GST_EVENT_TYPE_NAME (serial_event),
+        GST_TIME_ARGS (GST_EVENT_TIMESTAMP (serial_event)));
+    gst_pad_push_event (srcpad, serial_event);
+  }
+
+  if (src->shared_task_active && *buf
+      && gst_inter_pipe_src_hold_until_due (src, *buf)) {
+    *buf = NULL;
+    return GST_FLOW_FLUSHING;
   }
 
   return ret;
@@ -520,8 +1603,10 @@ gst_inter_pipe_ilistener_init (GstInterPipeIListenerInterface * iface)
   iface->get_caps = gst_inter_pipe_src_get_caps;
   iface->set_caps = gst_inter_pipe_src_set_caps;
   iface->push_buffer = gst_inter_pipe_src_push_buffer;
+  iface->push_buffer_list = gst_inter_pipe_src_push_buffer_list;
   iface->push_event = gst_inter_pipe_src_push_event;
   iface->send_eos = gst_inter_pipe_src_send_eos;
+  iface->attached = gst_inter_pipe_src_attached;
 }
 
 static const gchar *
@@ -540,8 +1625,8 @@ gst_inter_pipe_src_node_added (GstInterPipeIListener * iface,
 
   GST_INFO_OBJECT (src, "Node %s registered. Listening.", node_name);
 
-  if (g_strcmp0 (src->listen_to, node_name) == 0) {
-    gst_inter_pipe_src_listen_node (src, node_name);
+  if (gst_inter_pipe_src_is_listen_to (src, node_name)) {
+    gst_inter_pipe_src_listen_node (src, node_name, NULL);
   }
 
   return TRUE;
@@ -556,13 +1641,25 @@ gst_inter_pipe_src_node_removed (GstInterPipeIListener * iface,
   src = GST_INTER_PIPE_SRC (iface);
 
   GST_INFO_OBJECT (src, "Node %s removed. Leaving.", node_name);
-  if (g_strcmp0 (src->listen_to, node_name) == 0) {
+  if (gst_inter_pipe_src_is_listen_to (src, node_name)) {
     gst_inter_pipe_leave_node (iface);
   }
 
   return TRUE;
 }
 
+static void
+gst_inter_pipe_src_attached (GstInterPipeIListener * iface,
+    GstInterPipeINode * node)
+{
+  GstInterPipeSrc *src;
+
+  src = GST_INTER_PIPE_SRC (iface);
+
+  GST_DEBUG_OBJECT (src, "Attached to node %p", node);
+  g_weak_ref_set (&src->node, node);
+}
+
 static GstCaps *
 gst_inter_pipe_src_get_caps (GstInterPipeIListener * iface,
     gboolean * negotiated)
@@ -607,8 +1704,21 @@ gst_inter_pipe_src_set_caps (GstInterPipeIListener * iface,
   if (appcaps)
     gst_caps_unref (appcaps);
 
+  /* New caps have to reach downstream through the streaming thread,
+   * after the buffer being pushed directly with the old ones */
+  g_mutex_lock (&src->direct_lock);
+  src->direct_ready = FALSE;
+  while (src->direct_pushing)
+    g_cond_wait (&src->queue_cond, &src->direct_lock);
+  g_mutex_unlock (&src->direct_lock);
+
   gst_app_src_set_caps (appsrc, caps);
 
+  /* Applied by the streaming thread in order with the buffers */
+  if (src->ring_active)
+    gst_inter_pipe_src_ring_push (g_atomic_pointer_get (&src->ring),
+        GST_MINI_OBJECT_CAST (gst_caps_copy (caps)));
+
   return TRUE;
 
 allow_renegotiation_disabled:
@@ -627,7 +1737,10 @@ gst_inter_pipe_src_push_buffer (GstInterPipeIListener * iface,
   GstInterPipeSrc *src;
   GstAppSrc *appsrc;
   GstFlowReturn ret;
-  guint64 srcbasetime;
+  gchar *switch_to;
+  GstClockTimeDiff pad_offset = 0;
+  GstClockTimeDiff offset = 0;
+  gboolean shift = FALSE;
 
   src = GST_INTER_PIPE_SRC (iface);
   appsrc = GST_APP_SRC (src);
@@ -639,82 +1752,686 @@ gst_inter_pipe_src_push_buffer (GstInterPipeIListener * iface,
     goto out;
   }
 
-  if (GST_INTER_PIPE_SRC_COMPENSATE_TIMESTAMP == src->stream_sync) {
-    guint64 difftime;
+  /* The keyframe that completed a keyframe switch may come again in the
+   * replay of the node's GOP cache */
+  if (G_UNLIKELY (g_atomic_pointer_get (&src->cut_buffer))
+      && gst_inter_pipe_src_is_cut_duplicate (src, buffer)) {
+    GST_LOG_OBJECT (src, "Dropping the second copy of keyframe %p", buffer);
+    gst_buffer_unref (buffer);
+    goto out;
+  }
 
-    buffer = gst_buffer_make_writable (buffer);
+  /* Until the switcher detaches us, the rest of the buffers of the node
+   * are past the switch time */
+  if (g_atomic_int_get (&src->switch_due)
+      && GST_INTER_PIPE_SRC_SWITCH_IMMEDIATE == src->switch_mode) {
+    gst_buffer_unref (buffer);
+    goto out;
+  }
 
-    srcbasetime = gst_element_get_base_time (GST_ELEMENT (appsrc));
+  /* The buffers from the new node take over after this one. This is the
+   * node's streaming thread, the switch itself can't leave the node from
+   * here. Leaving waits for this push, so the buffer still goes out
+   * ahead of the new node's */
+  switch_to = gst_inter_pipe_src_take_scheduled_switch (src, buffer, basetime);
+  if (switch_to) {
+    GST_INFO_OBJECT (src, "Scheduled switch to node %s", switch_to);
+    g_atomic_int_set (&src->switch_due, TRUE);
+    g_thread_pool_push (gst_inter_pipe_src_switcher,
+        gst_inter_pipe_src_switch_new (src, switch_to), NULL);
+  }
 
-    GST_LOG_OBJECT (src, "Incoming Buffer timestamp (pts): %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
-    GST_LOG_OBJECT (src, "My Base Time: %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (srcbasetime));
-    GST_LOG_OBJECT (src, "Node Base Time: %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (basetime));
-
-    if (GST_STATE (src) == GST_STATE_PLAYING) {
-      if (srcbasetime > basetime) {
-        difftime = srcbasetime - basetime;
-        if (GST_BUFFER_PTS (buffer) >= difftime) {
-          GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS (buffer) - difftime;
-          if (GST_BUFFER_DTS (buffer) != GST_CLOCK_TIME_NONE ) {
-            GST_BUFFER_DTS (buffer) = GST_BUFFER_DTS (buffer) - difftime;
-          }
-        } else {
-          gst_buffer_unref (buffer);
-          goto nosync;
-        }
-      } else {
-        difftime = basetime - srcbasetime;
-        GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS (buffer) + difftime;
-        if (GST_BUFFER_DTS (buffer) != GST_CLOCK_TIME_NONE ) {
-          GST_BUFFER_DTS (buffer) = GST_BUFFER_DTS (buffer) + difftime;
-        }
-      }
-    } else {
-      /* srcbasetime is only valid when PLAYING, no adjustment can be done */
+  if (GST_INTER_PIPE_SRC_COMPENSATE_TIMESTAMP == src->stream_sync
+      || GST_INTER_PIPE_SRC_COMPENSATE_RUNNING_TIME == src->stream_sync) {
+    /* The base time is only valid when PLAYING, no adjustment can be done */
+    if (GST_STATE (src) != GST_STATE_PLAYING) {
       GST_LOG_OBJECT (src, "Not PLAYING state yet");
       gst_buffer_unref (buffer);
       goto nosync;
     }
 
-    GST_LOG_OBJECT (src,
-        "Calculated Buffer Timestamp (PTS): %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
+    /* Both base times are at hand, the offset is a subtraction away */
+    offset = GST_CLOCK_DIFF (gst_inter_pipe_src_get_base_time (src),
+        basetime);
+    shift = TRUE;
+  } else if (GST_INTER_PIPE_SRC_REBASE_TIMESTAMP == src->stream_sync) {
+    offset = gst_inter_pipe_src_rebase_offset (src, buffer);
+    shift = TRUE;
   } else if (GST_INTER_PIPE_SRC_RESTART_TIMESTAMP == src->stream_sync) {
     /* Remove the incoming timestamp to be generated according this basetime */
     GST_BUFFER_PTS (buffer) = GST_CLOCK_TIME_NONE;
     GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
   }
 
-  ret = gst_app_src_push_buffer (appsrc, buffer);
-  if (ret != GST_FLOW_OK)
-    return FALSE;
-out:
-  return TRUE;
-
-nosync:
-  {
-    GST_WARNING_OBJECT (src, "Buffers running time can not be synchronized yet"
-        " with the interpipesrc running time");
-    return FALSE;
-  }
-
-}
+  if (shift) {
+    GST_LOG_OBJECT (src, "Incoming Buffer timestamp (pts): %" GST_TIME_FORMAT
+        ", offset %" G_GINT64_FORMAT, GST_TIME_ARGS (GST_BUFFER_PTS (buffer)),
+        offset);
 
-static gboolean
+    if (offset < 0 && GST_BUFFER_PTS (buffer) < (GstClockTime) - offset) {
+      gst_buffer_unref (buffer);
+      goto nosync;
+    }
+#if GST_CHECK_VERSION(1,8,0)
+    /* The buffer is shared with the other listeners, shift our running
+     * time instead of copying it. Older versions clip negative offsets */
+    if (GST_INTER_PIPE_SRC_COMPENSATE_TIMESTAMP != src->stream_sync
+        && GST_FORMAT_TIME == GST_BASE_SRC (src)->segment.format) {
+      pad_offset = offset;
+      goto deliver;
+    }
+#endif
+
+    buffer = gst_buffer_make_writable (buffer);
+    if (GST_BUFFER_PTS_IS_VALID (buffer))
+      GST_BUFFER_PTS (buffer) += offset;
+    if (GST_BUFFER_DTS_IS_VALID (buffer))
+      GST_BUFFER_DTS (buffer) += offset;
+
+    GST_LOG_OBJECT (src,
+        "Calculated Buffer Timestamp (PTS): %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
+  }
+
+#if GST_CHECK_VERSION(1,8,0)
+deliver:
+#endif
+  ret = gst_inter_pipe_src_deliver (src, GST_MINI_OBJECT_CAST (buffer),
+      pad_offset);
+  if (ret != GST_FLOW_OK)
+    return FALSE;
+out:
+  return TRUE;
+
+nosync:
+  {
+    GST_WARNING_OBJECT (src, "Buffers running time can not be synchronized yet"
+        " with the interpipesrc running time");
+    return FALSE;
+  }
+
+}
+
+/* The offset that takes the first buffer after a switch to the current
+ * running time, kept for the rest of the buffers of that node */
+static GstClockTimeDiff
+gst_inter_pipe_src_rebase_offset (GstInterPipeSrc * src, GstBuffer * buffer)
+{
+  GstClock *clock;
+  GstClockTime now = 0;
+
+  if (!GST_BUFFER_PTS_IS_VALID (buffer)
+      || !g_atomic_int_compare_and_exchange (&src->rebase_pending, TRUE,
+          FALSE))
+    return src->rebase_offset;
+
+  /* Before PLAYING the first buffer starts at running time 0 */
+  if (GST_STATE (src) == GST_STATE_PLAYING
+      && (clock = gst_element_get_clock (GST_ELEMENT (src)))) {
+    now = gst_clock_get_time (clock);
+    gst_object_unref (clock);
+    now -= MIN (now, gst_inter_pipe_src_get_base_time (src));
+  }
+
+  src->rebase_offset = GST_CLOCK_DIFF (GST_BUFFER_PTS (buffer), now);
+  GST_DEBUG_OBJECT (src, "Rebasing %" GST_TIME_FORMAT " to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (GST_BUFFER_PTS (buffer)), GST_TIME_ARGS (now));
+
+  return src->rebase_offset;
+}
+
+/* Once create() returns, GstBaseSrc pauses the task, then the parker
+ * stops it and its thread goes back to the pool */
+static void
+gst_inter_pipe_src_release_thread (GstInterPipeSrc * src)
+{
+  GstPad *srcpad;
+
+  srcpad = GST_INTER_PIPE_SRC_PAD (src);
+
+  /* The first run comes from the default pool, the next ones don't */
+  if (!src->task_in_pool) {
+    GST_OBJECT_LOCK (srcpad);
+    if (GST_PAD_TASK (srcpad))
+      gst_task_set_pool (GST_PAD_TASK (srcpad),
+          gst_inter_pipe_task_pool_get_default ());
+    GST_OBJECT_UNLOCK (srcpad);
+    src->task_in_pool = TRUE;
+  }
+
+  src->task_slice = 0;
+  g_thread_pool_push (gst_inter_pipe_src_parker, gst_object_ref (src), NULL);
+}
+
+/* With a shared task, create() returns instead of waiting for data.
+ * The next delivery starts the task again. After EOS it stays parked
+ * until a flush */
+static gboolean
+gst_inter_pipe_src_park (GstInterPipeSrc * src, gboolean eos)
+{
+  g_mutex_lock (&src->direct_lock);
+  if (!eos && (src->queued > 0 || src->eos_queued)) {
+    g_mutex_unlock (&src->direct_lock);
+    return FALSE;
+  }
+  src->parked = TRUE;
+  g_mutex_unlock (&src->direct_lock);
+
+  GST_LOG_OBJECT (src, "Parking the streaming task");
+  gst_inter_pipe_src_release_thread (src);
+
+  return TRUE;
+}
+
+/* A task that always has data would keep its thread, so every few
+ * items it hands it over to the tasks waiting in the pool and queues up
+ * again behind them */
+static gboolean
+gst_inter_pipe_src_yield (GstInterPipeSrc * src)
+{
+  if (++src->task_slice < SHARED_TASK_SLICE)
+    return FALSE;
+
+  src->task_slice = 0;
+  if (!gst_inter_pipe_task_pool_has_waiting
+      (gst_inter_pipe_task_pool_get_default ()))
+    return FALSE;
+
+  g_mutex_lock (&src->direct_lock);
+  src->yielded = TRUE;
+  src->resume = TRUE;
+  g_mutex_unlock (&src->direct_lock);
+
+  GST_LOG_OBJECT (src, "Yielding the streaming thread");
+  gst_inter_pipe_src_release_thread (src);
+
+  return TRUE;
+}
+
+/* Runs on the clock thread, the parker starts the task instead */
+static gboolean
+gst_inter_pipe_src_due (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GstInterPipeSrc *src;
+  gboolean resume;
+
+  src = GST_INTER_PIPE_SRC (user_data);
+
+  g_mutex_lock (&src->direct_lock);
+  resume = src->yielded && src->due_clock_id == id;
+  if (resume)
+    src->resume = TRUE;
+  g_mutex_unlock (&src->direct_lock);
+
+  if (resume)
+    g_thread_pool_push (gst_inter_pipe_src_parker, gst_object_ref (src), NULL);
+
+  return TRUE;
+}
+
+/* A live source pushing ahead of the clock blocks its thread in the
+ * sink, or in a full queue before it, until the buffer is due. A shared
+ * task holds the buffer and gives its thread back for that time */
+static gboolean
+gst_inter_pipe_src_hold_until_due (GstInterPipeSrc * src, GstBuffer * buffer)
+{
+  GstSegment *segment;
+  GstClock *clock;
+  GstClockTime running_time;
+  GstClockTime due;
+  GstClockID id;
+
+  if (!gst_base_src_is_live (GST_BASE_SRC (src))
+      || GST_STATE (src) != GST_STATE_PLAYING)
+    return FALSE;
+
+  running_time = GST_BUFFER_PTS (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return FALSE;
+  running_time += src->pad_offset;
+
+  segment = &GST_BASE_SRC (src)->segment;
+  if (GST_FORMAT_TIME == segment->format)
+    running_time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+        running_time);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return FALSE;
+
+  clock = gst_element_get_clock (GST_ELEMENT (src));
+  if (!clock)
+    return FALSE;
+
+  due = gst_inter_pipe_src_get_base_time (src) + running_time;
+  if (gst_clock_get_time (clock) >= due) {
+    gst_object_unref (clock);
+    return FALSE;
+  }
+
+  id = gst_clock_new_single_shot_id (clock, due);
+  gst_object_unref (clock);
+
+  g_mutex_lock (&src->direct_lock);
+  src->due_buffer = buffer;
+  src->due_clock_id = id;
+  src->yielded = TRUE;
+  src->resume = FALSE;
+  g_mutex_unlock (&src->direct_lock);
+
+  GST_LOG_OBJECT (src, "Holding buffer %p until %" GST_TIME_FORMAT, buffer,
+      GST_TIME_ARGS (running_time));
+  gst_inter_pipe_src_release_thread (src);
+
+  if (gst_clock_id_wait_async (id, gst_inter_pipe_src_due,
+          gst_object_ref (src), gst_object_unref) != GST_CLOCK_OK)
+    gst_inter_pipe_src_due (NULL, GST_CLOCK_TIME_NONE, id, src);
+
+  return TRUE;
+}
+
+/* Called with direct_lock held, while the task isn't running */
+static void
+gst_inter_pipe_src_drop_due (GstInterPipeSrc * src)
+{
+  if (src->due_clock_id) {
+    gst_clock_id_unschedule (src->due_clock_id);
+    gst_clock_id_unref (src->due_clock_id);
+    src->due_clock_id = NULL;
+  }
+  if (src->due_buffer) {
+    gst_buffer_unref (src->due_buffer);
+    src->due_buffer = NULL;
+  }
+  src->yielded = FALSE;
+  src->resume = FALSE;
+}
+
+/* Runs on the parker thread, a task can't stop itself since GstBaseSrc
+ * pauses it right after create() returns. A task that yielded is
+ * started again right away, or once the clock says so */
+static void
+gst_inter_pipe_src_park_task (gpointer data, gpointer user_data)
+{
+  GstInterPipeSrc *src;
+  GstPad *srcpad;
+  GstTask *task;
+  gboolean parked;
+  gboolean resume;
+
+  src = GST_INTER_PIPE_SRC (data);
+  srcpad = GST_INTER_PIPE_SRC_PAD (src);
+
+  /* Only available once the task is done with its last iteration */
+  GST_PAD_STREAM_LOCK (srcpad);
+  g_mutex_lock (&src->direct_lock);
+  parked = src->parked || src->yielded;
+  resume = src->yielded && src->resume;
+  if (resume) {
+    src->yielded = FALSE;
+    src->resume = FALSE;
+  }
+  g_mutex_unlock (&src->direct_lock);
+
+  GST_OBJECT_LOCK (srcpad);
+  task = GST_PAD_TASK (srcpad);
+  if (parked && task && GST_TASK_PAUSED == gst_task_get_state (task)) {
+    GST_LOG_OBJECT (src, "Releasing the streaming thread");
+    gst_task_stop (task);
+  }
+  GST_OBJECT_UNLOCK (srcpad);
+  GST_PAD_STREAM_UNLOCK (srcpad);
+
+  if (resume)
+    gst_inter_pipe_src_wake (src);
+
+  gst_object_unref (src);
+}
+
+/* Starts a parked task again, paused or already stopped by the parker */
+static void
+gst_inter_pipe_src_wake (GstInterPipeSrc * src)
+{
+  GstPad *srcpad;
+  GstTask *task;
+
+  srcpad = GST_INTER_PIPE_SRC_PAD (src);
+
+  GST_LOG_OBJECT (src, "Waking up the streaming task");
+
+  /* Wait for the task to pause after parking */
+  GST_PAD_STREAM_LOCK (srcpad);
+  GST_OBJECT_LOCK (srcpad);
+  task = GST_PAD_TASK (srcpad);
+  if (task)
+    gst_object_ref (task);
+  GST_OBJECT_UNLOCK (srcpad);
+  GST_PAD_STREAM_UNLOCK (srcpad);
+
+  if (!task)
+    return;
+
+  /* A stopped run has to leave its thread before starting a new one */
+  if (GST_TASK_STOPPED == gst_task_get_state (task))
+    gst_task_join (task);
+
+  /* Not if the pad was deactivated meanwhile */
+  GST_OBJECT_LOCK (srcpad);
+  if (GST_PAD_TASK (srcpad) == task)
+    gst_task_start (task);
+  GST_OBJECT_UNLOCK (srcpad);
+
+  gst_object_unref (task);
+}
+
+static gboolean
+gst_inter_pipe_src_can_push_direct (GstInterPipeSrc * src)
+{
+  return src->direct_push && src->direct_ready && !src->task_busy
+      && !src->direct_pushing && 0 == src->queued
+      && GST_STATE (src) == GST_STATE_PLAYING
+      && GST_INTER_PIPE_SRC_RESTART_TIMESTAMP != src->stream_sync
+      && g_queue_is_empty (src->pending_serial_events);
+}
+
+/* Called with direct_lock held for every dequeued item */
+static void
+gst_inter_pipe_src_apply_offset (GstInterPipeSrc * src)
+{
+  GstInterPipeSrcOffsetChange *change;
+  GList *l;
+
+  while ((change = g_queue_peek_head (&src->offset_changes))
+      && 0 == change->ahead) {
+    g_queue_pop_head (&src->offset_changes);
+    if (change->offset != src->pad_offset) {
+      GST_DEBUG_OBJECT (src, "Running time offset %" G_GINT64_FORMAT,
+          change->offset);
+      gst_pad_set_offset (GST_INTER_PIPE_SRC_PAD (src), change->offset);
+      src->pad_offset = change->offset;
+    }
+    g_free (change);
+  }
+
+  for (l = src->offset_changes.head; l != NULL; l = l->next) {
+    change = l->data;
+    change->ahead--;
+  }
+}
+
+/* Called with direct_lock held, or before the source is shared */
+static void
+gst_inter_pipe_src_clear_offsets (GstInterPipeSrc * src)
+{
+  GstInterPipeSrcOffsetChange *change;
+
+  while ((change = g_queue_pop_head (&src->offset_changes)))
+    g_free (change);
+
+  if (src->pad_offset != 0)
+    gst_pad_set_offset (GST_INTER_PIPE_SRC_PAD (src), 0);
+  src->pad_offset = 0;
+  src->queued_offset = 0;
+}
+
+static guint
+gst_inter_pipe_src_data_size (GstMiniObject * data)
+{
+  GstBufferList *list;
+  guint i, len, size = 0;
+
+  if (GST_IS_BUFFER (data))
+    return gst_buffer_get_size (GST_BUFFER_CAST (data));
+
+  list = GST_BUFFER_LIST_CAST (data);
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++)
+    size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+  return size;
+}
+
+/* The timestamp of the last buffer in @data */
+static GstClockTime
+gst_inter_pipe_src_data_timestamp (GstMiniObject * data)
+{
+  GstBufferList *list;
+  guint len;
+
+  if (GST_IS_BUFFER (data))
+    return GST_BUFFER_DTS_OR_PTS (GST_BUFFER_CAST (data));
+
+  list = GST_BUFFER_LIST_CAST (data);
+  len = gst_buffer_list_length (list);
+  if (0 == len)
+    return GST_CLOCK_TIME_NONE;
+
+  return GST_BUFFER_DTS_OR_PTS (gst_buffer_list_get (list, len - 1));
+}
+
+/* Whether the queue holds @factor times any of its limits, must be
+ * called with direct_lock held */
+static gboolean
+gst_inter_pipe_src_queue_is_full (GstInterPipeSrc * src, guint factor)
+{
+  guint64 bytes;
+
+  if (src->queue_max_buffers
+      && src->queued >= (guint64) src->queue_max_buffers * factor)
+    return TRUE;
+
+  if (src->queue_max_bytes) {
+    if (src->ring_active)
+      bytes = MAX (g_atomic_int_get (&src->queued_bytes), 0);
+    else
+      bytes = gst_app_src_get_current_level_bytes (GST_APP_SRC (src));
+
+    if (bytes >= (guint64) src->queue_max_bytes * factor)
+      return TRUE;
+  }
+
+  return src->queue_max_time && GST_CLOCK_TIME_IS_VALID (src->queued_in_ts)
+      && GST_CLOCK_TIME_IS_VALID (src->queued_out_ts)
+      && src->queued_in_ts > src->queued_out_ts
+      && src->queued_in_ts - src->queued_out_ts >=
+      src->queue_max_time * factor;
+}
+
+/* Push a buffer or buffer list downstream from the calling thread if
+ * the streaming thread has nothing pending, so nothing is overtaken.
+ * Otherwise queue it in appsrc or the ring */
+static GstFlowReturn
+gst_inter_pipe_src_deliver (GstInterPipeSrc * src, GstMiniObject * data,
+    GstClockTimeDiff offset)
+{
+  GstAppSrc *appsrc;
+  GstPad *srcpad;
+  GstFlowReturn ret;
+  GstClockTime ts;
+  gboolean wake;
+  GList *l;
+
+  appsrc = GST_APP_SRC (src);
+  srcpad = GST_INTER_PIPE_SRC_PAD (src);
+
+  if (src->ring_lockless) {
+    gst_inter_pipe_src_ring_push (g_atomic_pointer_get (&src->ring), data);
+    return GST_FLOW_OK;
+  }
+
+  g_mutex_lock (&src->direct_lock);
+  if (gst_inter_pipe_src_can_push_direct (src)) {
+    GST_LOG_OBJECT (src, "Pushing %p directly", data);
+    if (offset != src->pad_offset) {
+      gst_pad_set_offset (srcpad, offset);
+      src->pad_offset = offset;
+    }
+    src->queued_offset = offset;
+    /* Whatever arrives meanwhile is queued behind it */
+    src->direct_pushing = TRUE;
+    g_mutex_unlock (&src->direct_lock);
+
+#if GST_CHECK_VERSION(1,14,0)
+    if (GST_IS_BUFFER_LIST (data))
+      ret = gst_pad_push_list (srcpad, GST_BUFFER_LIST_CAST (data));
+    else
+#endif
+      ret = gst_pad_push (srcpad, GST_BUFFER_CAST (data));
+
+    g_mutex_lock (&src->direct_lock);
+    src->direct_pushing = FALSE;
+    /* Flushing, not linked or EOS: leave it to the streaming thread
+     * until it is back downstream */
+    if (ret != GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (src, "Direct push returned %s",
+          gst_flow_get_name (ret));
+      src->direct_ready = FALSE;
+    }
+    g_cond_broadcast (&src->queue_cond);
+    g_mutex_unlock (&src->direct_lock);
+
+    return ret;
+  }
+
+  while (gst_inter_pipe_src_queue_is_full (src, 1)) {
+    if (GST_INTER_PIPE_SRC_LEAKY_UPSTREAM == src->queue_leaky)
+      goto drop;
+
+    /* The streaming thread drops the old ones, unless it is stuck */
+    if (GST_INTER_PIPE_SRC_LEAKY_DOWNSTREAM == src->queue_leaky) {
+      if (gst_inter_pipe_src_queue_is_full (src, 2))
+        goto drop;
+      break;
+    }
+
+    if (src->queue_flushing)
+      goto flushing;
+
+    g_cond_wait (&src->queue_cond, &src->direct_lock);
+  }
+
+  /* Takes over on the pad once the items ahead are dequeued */
+  if (offset != src->queued_offset) {
+    GstInterPipeSrcOffsetChange *change;
+
+    change = g_new (GstInterPipeSrcOffsetChange, 1);
+    change->ahead = src->queued;
+    change->offset = offset;
+    g_queue_push_tail (&src->offset_changes, change);
+    src->queued_offset = offset;
+  }
+
+  ts = gst_inter_pipe_src_data_timestamp (data);
+  if (0 == src->queued)
+    src->queued_out_ts = ts;
+  if (GST_CLOCK_TIME_IS_VALID (ts))
+    src->queued_in_ts = ts;
+  if (src->ring_active)
+    g_atomic_int_add (&src->queued_bytes,
+        (gint) gst_inter_pipe_src_data_size (data));
+  src->queued++;
+  wake = src->parked && !src->eos_queued;
+  if (wake)
+    src->parked = FALSE;
+  g_mutex_unlock (&src->direct_lock);
+
+  if (src->ring_active) {
+    gst_inter_pipe_src_ring_push (g_atomic_pointer_get (&src->ring), data);
+    ret = GST_FLOW_OK;
+    goto wake;
+  }
+
+  /* appsrc may block when full, never do it holding the lock */
+#if GST_CHECK_VERSION(1,14,0)
+  if (GST_IS_BUFFER_LIST (data))
+    ret = gst_app_src_push_buffer_list (appsrc, GST_BUFFER_LIST_CAST (data));
+  else
+#endif
+    ret = gst_app_src_push_buffer (appsrc, GST_BUFFER_CAST (data));
+
+  if (ret == GST_FLOW_OK)
+    goto wake;
+
+  /* Not queued after all */
+  g_mutex_lock (&src->direct_lock);
+  if (src->queued > 0)
+    src->queued--;
+  src->stale_buffers = MIN (src->stale_buffers, src->queued);
+  src->held_stale_buffers = MIN (src->held_stale_buffers, src->stale_buffers);
+  for (l = src->offset_changes.head; l != NULL; l = l->next) {
+    GstInterPipeSrcOffsetChange *change = l->data;
+    change->ahead = MIN (change->ahead, src->queued);
+  }
+  g_mutex_unlock (&src->direct_lock);
+
+wake:
+  if (wake)
+    gst_inter_pipe_src_wake (src);
+
+  return ret;
+
+drop:
+  {
+    g_mutex_unlock (&src->direct_lock);
+    GST_LOG_OBJECT (src, "Queue full, dropping new %p", data);
+    gst_mini_object_unref (data);
+    return GST_FLOW_OK;
+  }
+flushing:
+  {
+    g_mutex_unlock (&src->direct_lock);
+    gst_mini_object_unref (data);
+    return GST_FLOW_FLUSHING;
+  }
+}
+
+static gboolean
+gst_inter_pipe_src_push_buffer_list (GstInterPipeIListener * iface,
+    GstBufferList * list, guint64 basetime)
+{
+  GstInterPipeSrc *src;
+  GstAppSrc *appsrc;
+  gboolean ret = TRUE;
+  guint i, len;
+
+  src = GST_INTER_PIPE_SRC (iface);
+  appsrc = GST_APP_SRC (src);
+
+  GST_LOG_OBJECT (src, "Incoming buffer list: %p", list);
+
+#if GST_CHECK_VERSION(1,14,0)
+  /* Retimestamping and scheduled switches need to look at every buffer */
+  if (GST_INTER_PIPE_SRC_PASSTHROUGH_TIMESTAMP == src->stream_sync
+      && !g_atomic_pointer_get (&src->switch_to)
+      && !g_atomic_int_get (&src->switch_due)) {
+    if (GST_STATE (GST_ELEMENT (appsrc)) < GST_STATE_PAUSED) {
+      gst_buffer_list_unref (list);
+      return TRUE;
+    }
+
+    return GST_FLOW_OK == gst_inter_pipe_src_deliver (src,
+        GST_MINI_OBJECT_CAST (list), 0);
+  }
+#endif
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++)
+    ret &= gst_inter_pipe_src_push_buffer (iface,
+        gst_buffer_ref (gst_buffer_list_get (list, i)), basetime);
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
+static gboolean
 gst_inter_pipe_src_push_event (GstInterPipeIListener * iface, GstEvent * event,
     guint64 basetime)
 {
   GstInterPipeSrc *src;
-  GstAppSrc *appsrc;
   GstPad *srcpad;
   guint64 srcbasetime;
   gboolean ret = TRUE;
 
   src = GST_INTER_PIPE_SRC (iface);
-  appsrc = GST_APP_SRC (src);
   srcpad = GST_INTER_PIPE_SRC_PAD (src);
 
   if (!src->accept_events)
@@ -729,7 +2446,7 @@ gst_inter_pipe_src_push_event (GstInterPipeIListener * iface, GstEvent * event,
   } else {
 
     event = gst_event_make_writable (event);
-    srcbasetime = gst_element_get_base_time (GST_ELEMENT (appsrc));
+    srcbasetime = gst_inter_pipe_src_get_base_time (src);
 
     if (srcbasetime > basetime) {
       GST_EVENT_TIMESTAMP (event) =
@@ -744,7 +2461,9 @@ gst_inter_pipe_src_push_event (GstInterPipeIListener * iface, GstEvent * event,
         " enqueued on serial pending events", GST_EVENT_TYPE_NAME (event),
         GST_TIME_ARGS (GST_EVENT_TIMESTAMP (event)));
 
-    g_queue_push_tail (src->pending_serial_events, event);
+    g_mutex_lock (&src->direct_lock);
+    gst_inter_pipe_src_queue_event (src, event);
+    g_mutex_unlock (&src->direct_lock);
   }
   return ret;
 no_events:
@@ -756,19 +2475,62 @@ no_events:
   }
 }
 
+static gint
+gst_inter_pipe_src_event_compare (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  /* Equal timestamps keep their arrival order */
+  return GST_EVENT_TIMESTAMP (a) <= GST_EVENT_TIMESTAMP (b) ? -1 : 1;
+}
+
+/* Called with direct_lock held. Events usually arrive in order, so
+ * the sorted insert is only needed after a switch */
+static void
+gst_inter_pipe_src_queue_event (GstInterPipeSrc * src, GstEvent * event)
+{
+  GstEvent *last;
+
+  last = g_queue_peek_tail (src->pending_serial_events);
+  if (!last || GST_EVENT_TIMESTAMP (last) <= GST_EVENT_TIMESTAMP (event))
+    g_queue_push_tail (src->pending_serial_events, event);
+  else
+    g_queue_insert_sorted (src->pending_serial_events, event,
+        gst_inter_pipe_src_event_compare, NULL);
+  g_atomic_int_inc (&src->pending_events);
+}
+
 static gboolean
 gst_inter_pipe_src_send_eos (GstInterPipeIListener * iface)
 {
   GstInterPipeSrc *src;
   GstAppSrc *appsrc;
   GstFlowReturn ret;
+  gboolean wake;
 
   src = GST_INTER_PIPE_SRC (iface);
   appsrc = GST_APP_SRC (src);
 
   if (src->accept_eos_event) {
     GST_LOG_OBJECT (src, "Sending EOS event");
-    ret = gst_app_src_end_of_stream (appsrc);
+
+    /* A parked task has to come back to push it */
+    g_mutex_lock (&src->direct_lock);
+    wake = src->parked && !src->eos_queued;
+    if (wake)
+      src->parked = FALSE;
+    src->eos_queued = TRUE;
+    g_mutex_unlock (&src->direct_lock);
+
+    if (src->ring_active) {
+      gst_inter_pipe_src_ring_push (g_atomic_pointer_get (&src->ring),
+          GST_MINI_OBJECT_CAST (gst_event_new_eos ()));
+      ret = GST_FLOW_OK;
+    } else {
+      ret = gst_app_src_end_of_stream (appsrc);
+    }
+
+    if (wake)
+      gst_inter_pipe_src_wake (src);
     if (ret != GST_FLOW_OK)
       return FALSE;
   }
@@ -776,9 +2538,12 @@ gst_inter_pipe_src_send_eos (GstInterPipeIListener * iface)
 }
 
 static gboolean
-gst_inter_pipe_src_listen_node (GstInterPipeSrc * src, const gchar * node_name)
+gst_inter_pipe_src_listen_node (GstInterPipeSrc * src, const gchar * node_name,
+    GstInterPipeINode * node)
 {
   GstInterPipeIListener *listener;
+  gchar *listen_to;
+  gboolean ret;
 
   listener = GST_INTER_PIPE_ILISTENER (src);
 
@@ -788,9 +2553,26 @@ gst_inter_pipe_src_listen_node (GstInterPipeSrc * src, const gchar * node_name)
   if (src->first_switch)
     src->first_switch = FALSE;
 
-  if (!gst_inter_pipe_listen_node (listener, node_name)) {
+  /* A new switch replaces the one waiting for a keyframe */
+  gst_inter_pipe_src_cancel_switch (src);
+
+  if (GST_INTER_PIPE_SRC_SWITCH_KEYFRAME == src->switch_mode && src->listening)
+    return gst_inter_pipe_src_switch_on_keyframe (src, node_name, node);
+
+  gst_inter_pipe_src_prepare_switch (src, FALSE);
+
+  /* Switching through a handle skips the name lookup */
+  if (node)
+    ret = gst_inter_pipe_listen_inode (listener, node);
+  else
+    ret = gst_inter_pipe_listen_node (listener, node_name);
+
+  if (!ret) {
     gst_inter_pipe_leave_node (listener);
-    gst_inter_pipe_listen_node (listener, src->listen_to);
+    listen_to = gst_inter_pipe_src_dup_listen_to (src);
+    if (listen_to)
+      gst_inter_pipe_listen_node (listener, listen_to);
+    g_free (listen_to);
     return FALSE;
   } else {
     return TRUE;
@@ -803,3 +2585,877 @@ block_switch:
     return FALSE;
   }
 }
+
+gboolean
+gst_inter_pipe_src_listen_inode (GstInterPipeSrc * src,
+    GstInterPipeINode * node)
+{
+  gchar *node_name;
+
+  g_return_val_if_fail (GST_IS_INTER_PIPE_SRC (src), FALSE);
+  g_return_val_if_fail (GST_INTER_PIPE_IS_INODE (node), FALSE);
+
+  node_name = gst_inter_pipe_get_node_name (node);
+  if (!node_name)
+    goto not_registered;
+
+  if (gst_inter_pipe_src_is_listen_to (src, node_name)) {
+    GST_INFO_OBJECT (src, "Already listening to node %s", node_name);
+    g_free (node_name);
+    return TRUE;
+  }
+
+  if (GST_BASE_SRC_IS_STARTED (GST_BASE_SRC (src))) {
+    if (!gst_inter_pipe_src_listen_node (src, node_name, node)) {
+      GST_ERROR_OBJECT (src, "Could not listen to node %s", node_name);
+      g_free (node_name);
+      return FALSE;
+    }
+    src->listening = TRUE;
+  }
+
+  gst_inter_pipe_src_set_listen_to (src, node_name);
+  GST_INFO_OBJECT (src, "Listening to node %s", node_name);
+  g_free (node_name);
+
+  return TRUE;
+
+not_registered:
+  {
+    GST_ERROR_OBJECT (src, "Node %p is not registered", node);
+    return FALSE;
+  }
+}
+
+gboolean
+gst_inter_pipe_src_listen_inodes (GstInterPipeSrc ** srcs,
+    GstInterPipeINode ** nodes, guint num_srcs)
+{
+  GstInterPipeIListener **listeners;
+  GstInterPipeINode **switch_nodes;
+  gchar **node_names;
+  guint num_switch = 0;
+  guint i;
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail (srcs != NULL, FALSE);
+  g_return_val_if_fail (nodes != NULL, FALSE);
+
+  listeners = g_new0 (GstInterPipeIListener *, num_srcs);
+  switch_nodes = g_new0 (GstInterPipeINode *, num_srcs);
+  node_names = g_new0 (gchar *, num_srcs + 1);
+
+  /* Validate every source before switching any of them */
+  for (i = 0; i < num_srcs; i++) {
+    node_names[i] = gst_inter_pipe_get_node_name (nodes[i]);
+    if (!node_names[i])
+      goto not_registered;
+
+    if (!GST_BASE_SRC_IS_STARTED (GST_BASE_SRC (srcs[i]))
+        || gst_inter_pipe_src_is_listen_to (srcs[i], node_names[i]))
+      continue;
+
+    if (!srcs[i]->first_switch && srcs[i]->block_switch)
+      goto block_switch;
+
+    listeners[num_switch] = GST_INTER_PIPE_ILISTENER (srcs[i]);
+    switch_nodes[num_switch] = nodes[i];
+    num_switch++;
+  }
+
+  /* The batch replaces any switch waiting for a keyframe */
+  for (i = 0; i < num_srcs; i++)
+    gst_inter_pipe_src_cancel_switch (srcs[i]);
+
+  /* Held until the batch is done, a failed batch puts the sources back
+   * on their nodes and they keep what those queued */
+  for (i = 0; i < num_switch; i++)
+    gst_inter_pipe_src_prepare_switch (GST_INTER_PIPE_SRC (listeners[i]),
+        TRUE);
+
+  ret = gst_inter_pipe_listen_inodes (listeners, switch_nodes, num_switch);
+
+  for (i = 0; i < num_switch; i++)
+    gst_inter_pipe_src_release_switch (GST_INTER_PIPE_SRC (listeners[i]), ret);
+
+  if (!ret) {
+    GST_ERROR ("Could not switch %u interpipesrcs", num_switch);
+    goto out;
+  }
+
+  for (i = 0; i < num_srcs; i++) {
+    if (GST_BASE_SRC_IS_STARTED (GST_BASE_SRC (srcs[i]))
+        && !gst_inter_pipe_src_is_listen_to (srcs[i], node_names[i])) {
+      srcs[i]->first_switch = FALSE;
+      srcs[i]->listening = TRUE;
+    }
+    gst_inter_pipe_src_set_listen_to (srcs[i], node_names[i]);
+  }
+
+out:
+  g_free (listeners);
+  g_free (switch_nodes);
+  g_strfreev (node_names);
+
+  return ret;
+
+not_registered:
+  {
+    GST_ERROR_OBJECT (srcs[i], "Node %p is not registered", nodes[i]);
+    goto out;
+  }
+block_switch:
+  {
+    GST_ERROR_OBJECT (srcs[i], "Can not connect to the node %s because the "
+        "block-switch property is set to true", node_names[i]);
+    goto out;
+  }
+}
+
+static gboolean
+gst_inter_pipe_src_schedule_switch (GstInterPipeSrc * src,
+    const gchar * node_name, guint64 running_time)
+{
+  gchar *previous;
+
+  g_return_val_if_fail (GST_IS_INTER_PIPE_SRC (src), FALSE);
+
+  if (node_name && !GST_CLOCK_TIME_IS_VALID (running_time))
+    goto invalid_time;
+
+  GST_INFO_OBJECT (src, "Switching to node %s at %" GST_TIME_FORMAT,
+      GST_STR_NULL (node_name), GST_TIME_ARGS (running_time));
+
+  GST_OBJECT_LOCK (src);
+  previous = src->switch_to;
+  src->switch_time = running_time;
+  g_atomic_pointer_set (&src->switch_to, g_strdup (node_name));
+  GST_OBJECT_UNLOCK (src);
+
+  g_free (previous);
+
+  return TRUE;
+
+invalid_time:
+  {
+    GST_ERROR_OBJECT (src, "Invalid running time to switch to node %s",
+        node_name);
+    return FALSE;
+  }
+}
+
+static GstInterPipeSrcSwitch *
+gst_inter_pipe_src_switch_new (GstInterPipeSrc * src, gchar * node_name)
+{
+  GstInterPipeSrcSwitch *job;
+
+  job = g_new0 (GstInterPipeSrcSwitch, 1);
+  job->src = gst_object_ref (src);
+  job->node_name = node_name;
+
+  return job;
+}
+
+/* Must be called with switch_lock held */
+static void
+gst_inter_pipe_src_run_switch (GstInterPipeSrc * src, const gchar * node_name)
+{
+  GstInterPipeIListener *listener;
+  gchar *listen_to;
+
+  listener = GST_INTER_PIPE_ILISTENER (src);
+
+  /* Stop taking buffers from the node before the new one starts. A
+   * keyframe switch keeps it until the new node has a keyframe */
+  if (GST_INTER_PIPE_SRC_SWITCH_IMMEDIATE == src->switch_mode
+      && src->listening)
+    gst_inter_pipe_leave_node (listener);
+  g_atomic_int_set (&src->switch_due, FALSE);
+
+  if (gst_inter_pipe_src_listen_node (src, node_name, NULL)) {
+    gst_inter_pipe_src_set_listen_to (src, node_name);
+  } else {
+    GST_ERROR_OBJECT (src, "Could not listen to node %s", node_name);
+    /* Back to the node left above */
+    listen_to = gst_inter_pipe_src_dup_listen_to (src);
+    if (listen_to && src->listening)
+      gst_inter_pipe_listen_node (listener, listen_to);
+    g_free (listen_to);
+  }
+}
+
+/* Runs on the switcher, stop() waits for it and cancels the pending ones */
+static void
+gst_inter_pipe_src_switch_task (gpointer data, gpointer user_data)
+{
+  GstInterPipeSrcSwitch *job;
+
+  job = data;
+
+  g_mutex_lock (&job->src->switch_lock);
+  if (job->src->switch_due)
+    gst_inter_pipe_src_run_switch (job->src, job->node_name);
+  else
+    GST_INFO_OBJECT (job->src, "Switch to node %s cancelled", job->node_name);
+  g_mutex_unlock (&job->src->switch_lock);
+
+  gst_object_unref (job->src);
+  g_free (job->node_name);
+  g_free (job);
+}
+
+/* Returns the node to switch to if @buffer reaches the scheduled time,
+ * free it with g_free() */
+static gchar *
+gst_inter_pipe_src_take_scheduled_switch (GstInterPipeSrc * src,
+    GstBuffer * buffer, guint64 basetime)
+{
+  GstClockTime srcbasetime;
+  GstClockTime running_time;
+  gchar *switch_to = NULL;
+
+  /* Only a hint, it is checked again with the lock held */
+  if (!g_atomic_pointer_get (&src->switch_to)
+      || !GST_BUFFER_PTS_IS_VALID (buffer))
+    return NULL;
+
+  /* The running time of the buffer in this pipeline, as the compensated
+     timestamp would be */
+  srcbasetime = gst_inter_pipe_src_get_base_time (src);
+  if (GST_STATE (src) != GST_STATE_PLAYING
+      || basetime + GST_BUFFER_PTS (buffer) < srcbasetime)
+    return NULL;
+  running_time = basetime + GST_BUFFER_PTS (buffer) - srcbasetime;
+
+  GST_OBJECT_LOCK (src);
+  if (src->switch_to && running_time >= src->switch_time) {
+    switch_to = src->switch_to;
+    g_atomic_pointer_set (&src->switch_to, NULL);
+    src->switch_time = GST_CLOCK_TIME_NONE;
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  return switch_to;
+}
+
+/* Called right before attaching to a new node. With flush-on-switch,
+ * marks what is queued so far as stale. The streaming thread drops it
+ * as it dequeues, so the node never waits on it and nothing from the
+ * new node is lost. With @hold the switch may still be rolled back, the
+ * marked items keep going downstream until it is released */
+static void
+gst_inter_pipe_src_prepare_switch (GstInterPipeSrc * src, gboolean hold)
+{
+  gint rebase;
+
+  rebase = g_atomic_int_get (&src->rebase_pending);
+  g_atomic_int_set (&src->rebase_pending, TRUE);
+  gst_inter_pipe_src_set_cut_buffer (src, NULL);
+
+  g_mutex_lock (&src->direct_lock);
+  src->switch_held = hold;
+  src->held_rebase = rebase;
+  src->held_stale_buffers = 0;
+  src->held_stale_events = 0;
+  if (src->flush_on_switch) {
+    guint buffers = src->stale_buffers;
+    guint events = src->stale_events;
+
+    src->stale_buffers = src->queued;
+    src->stale_events = g_queue_get_length (src->pending_serial_events);
+    if (hold) {
+      src->held_stale_buffers = src->stale_buffers - MIN (buffers,
+          src->stale_buffers);
+      src->held_stale_events = src->stale_events - MIN (events,
+          src->stale_events);
+    }
+    GST_DEBUG_OBJECT (src, "Dropping %u buffers and %u events queued from "
+        "the previous node", src->stale_buffers, src->stale_events);
+  }
+  g_mutex_unlock (&src->direct_lock);
+}
+
+/* Ends a held switch. Once committed the streaming thread drops what is
+ * still marked. Rolled back, the listener is on the node that queued
+ * those items again: the marks of the switch are cleared and the
+ * timeline is kept, unless a buffer from the new node already moved it */
+static void
+gst_inter_pipe_src_release_switch (GstInterPipeSrc * src, gboolean commit)
+{
+  g_mutex_lock (&src->direct_lock);
+  if (!src->switch_held)
+    goto out;
+
+  src->switch_held = FALSE;
+  if (!commit) {
+    GST_DEBUG_OBJECT (src, "Switch rolled back, keeping %u buffers and %u "
+        "events", src->held_stale_buffers, src->held_stale_events);
+    src->stale_buffers -= src->held_stale_buffers;
+    src->stale_events -= src->held_stale_events;
+    if (!g_atomic_int_compare_and_exchange (&src->rebase_pending, TRUE,
+            src->held_rebase))
+      g_atomic_int_set (&src->rebase_pending, TRUE);
+  }
+  src->held_stale_buffers = 0;
+  src->held_stale_events = 0;
+
+out:
+  g_mutex_unlock (&src->direct_lock);
+}
+
+/* listen-to is also read from the node and upstream event threads */
+static void
+gst_inter_pipe_src_set_listen_to (GstInterPipeSrc * src,
+    const gchar * node_name)
+{
+  gchar *previous;
+
+  GST_OBJECT_LOCK (src);
+  previous = src->listen_to;
+  src->listen_to = g_strdup (node_name);
+  GST_OBJECT_UNLOCK (src);
+
+  g_free (previous);
+}
+
+static gchar *
+gst_inter_pipe_src_dup_listen_to (GstInterPipeSrc * src)
+{
+  gchar *listen_to;
+
+  GST_OBJECT_LOCK (src);
+  listen_to = g_strdup (src->listen_to);
+  GST_OBJECT_UNLOCK (src);
+
+  return listen_to;
+}
+
+static gboolean
+gst_inter_pipe_src_is_listen_to (GstInterPipeSrc * src,
+    const gchar * node_name)
+{
+  gboolean ret;
+
+  GST_OBJECT_LOCK (src);
+  ret = 0 == g_strcmp0 (src->listen_to, node_name);
+  GST_OBJECT_UNLOCK (src);
+
+  return ret;
+}
+
+static void
+gst_inter_pipe_src_set_cut_buffer (GstInterPipeSrc * src, GstBuffer * buffer)
+{
+  GstBuffer *previous;
+
+  GST_OBJECT_LOCK (src);
+  previous = src->cut_buffer;
+  g_atomic_pointer_set (&src->cut_buffer,
+      buffer ? gst_buffer_ref (buffer) : NULL);
+  src->cut_seen = FALSE;
+  GST_OBJECT_UNLOCK (src);
+
+  if (previous)
+    gst_buffer_unref (previous);
+}
+
+/* The first copy of the cut keyframe goes through, the second one is
+ * dropped and ends the check */
+static gboolean
+gst_inter_pipe_src_is_cut_duplicate (GstInterPipeSrc * src,
+    GstBuffer * buffer)
+{
+  GstBuffer *cut = NULL;
+
+  GST_OBJECT_LOCK (src);
+  if (src->cut_buffer == buffer) {
+    if (src->cut_seen) {
+      cut = src->cut_buffer;
+      g_atomic_pointer_set (&src->cut_buffer, NULL);
+    } else {
+      src->cut_seen = TRUE;
+    }
+  }
+  GST_OBJECT_UNLOCK (src);
+
+  if (!cut)
+    return FALSE;
+
+  gst_buffer_unref (cut);
+  return TRUE;
+}
+
+/* Keyframe switch */
+static gboolean
+gst_inter_pipe_src_switch_on_keyframe (GstInterPipeSrc * src,
+    const gchar * node_name, GstInterPipeINode * node)
+{
+  GstInterPipeSrcProxy *proxy;
+  gboolean ret;
+
+  proxy = g_object_new (GST_TYPE_INTER_PIPE_SRC_PROXY, NULL);
+  proxy->src = gst_object_ref (src);
+  proxy->name = g_strdup_printf ("%s:keyframe-switch", GST_OBJECT_NAME (src));
+  proxy->node = g_strdup (node_name);
+
+  GST_OBJECT_LOCK (src);
+  src->switch_proxy = g_object_ref (proxy);
+  GST_OBJECT_UNLOCK (src);
+
+  GST_INFO_OBJECT (src, "Waiting for a keyframe from node %s", node_name);
+
+  proxy->attach_thread = g_thread_self ();
+  if (node)
+    ret = gst_inter_pipe_listen_inode (GST_INTER_PIPE_ILISTENER (proxy), node);
+  else
+    ret = gst_inter_pipe_listen_node (GST_INTER_PIPE_ILISTENER (proxy),
+        node_name);
+  proxy->attach_thread = NULL;
+
+  if (!ret) {
+    GST_ERROR_OBJECT (src, "Could not attach to node %s", node_name);
+    gst_inter_pipe_src_cancel_switch (src);
+  } else if (proxy->cut_pending) {
+    /* The source gets the keyframe from the same replay the proxy saw */
+    gst_inter_pipe_src_cut_over (src, proxy, NULL);
+  }
+
+  g_object_unref (proxy);
+
+  return ret;
+}
+
+static void
+gst_inter_pipe_src_cancel_switch (GstInterPipeSrc * src)
+{
+  GstInterPipeSrcProxy *proxy;
+
+  GST_OBJECT_LOCK (src);
+  proxy = src->switch_proxy;
+  src->switch_proxy = NULL;
+  GST_OBJECT_UNLOCK (src);
+
+  if (!proxy)
+    return;
+
+  GST_INFO_OBJECT (src, "Cancelling the switch to node %s", proxy->node);
+  gst_inter_pipe_leave_node (GST_INTER_PIPE_ILISTENER (proxy));
+  g_object_unref (proxy);
+}
+
+/* Called from the new node's streaming thread on its first keyframe,
+ * @buffer is NULL if the proxy dropped it */
+static gboolean
+gst_inter_pipe_src_cut_over (GstInterPipeSrc * src,
+    GstInterPipeSrcProxy * proxy, GstBuffer * buffer)
+{
+  gboolean ret;
+
+  GST_OBJECT_LOCK (src);
+  if (src->switch_proxy != proxy) {
+    GST_OBJECT_UNLOCK (src);
+    return FALSE;
+  }
+  src->switch_proxy = NULL;
+  GST_OBJECT_UNLOCK (src);
+
+  GST_INFO_OBJECT (src, "Keyframe received, switching to node %s",
+      proxy->node);
+
+  gst_inter_pipe_leave_node (GST_INTER_PIPE_ILISTENER (proxy));
+  gst_inter_pipe_src_prepare_switch (src, FALSE);
+  gst_inter_pipe_src_set_cut_buffer (src, buffer);
+  ret = gst_inter_pipe_listen_node (GST_INTER_PIPE_ILISTENER (src),
+      proxy->node);
+  if (!ret)
+    GST_ERROR_OBJECT (src, "Could not listen to node %s", proxy->node);
+
+  g_object_unref (proxy);
+
+  return ret;
+}
+
+static void
+gst_inter_pipe_src_proxy_finalize (GObject * object)
+{
+  GstInterPipeSrcProxy *proxy;
+
+  proxy = GST_INTER_PIPE_SRC_PROXY (object);
+  gst_object_unref (proxy->src);
+  g_free (proxy->name);
+  g_free (proxy->node);
+
+  G_OBJECT_CLASS (gst_inter_pipe_src_proxy_parent_class)->finalize (object);
+}
+
+static void
+gst_inter_pipe_src_proxy_class_init (GstInterPipeSrcProxyClass * klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = gst_inter_pipe_src_proxy_finalize;
+}
+
+static void
+gst_inter_pipe_src_proxy_init (GstInterPipeSrcProxy * proxy)
+{
+}
+
+static const gchar *
+gst_inter_pipe_src_proxy_get_name (GstInterPipeIListener * iface)
+{
+  return GST_INTER_PIPE_SRC_PROXY (iface)->name;
+}
+
+static GstCaps *
+gst_inter_pipe_src_proxy_get_caps (GstInterPipeIListener * iface,
+    gboolean * negotiated)
+{
+  GstInterPipeSrcProxy *proxy;
+
+  proxy = GST_INTER_PIPE_SRC_PROXY (iface);
+
+  /* The node must be compatible with the source it will feed */
+  return gst_inter_pipe_src_get_caps (GST_INTER_PIPE_ILISTENER (proxy->src),
+      negotiated);
+}
+
+static gboolean
+gst_inter_pipe_src_proxy_set_caps (GstInterPipeIListener * iface,
+    const GstCaps * caps)
+{
+  /* Caps are set on the source once it is attached to the node */
+  return TRUE;
+}
+
+static gboolean
+gst_inter_pipe_src_proxy_node_added (GstInterPipeIListener * iface,
+    const gchar * node_name)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_inter_pipe_src_proxy_node_removed (GstInterPipeIListener * iface,
+    const gchar * node_name)
+{
+  GstInterPipeSrcProxy *proxy;
+
+  proxy = GST_INTER_PIPE_SRC_PROXY (iface);
+
+  GST_OBJECT_LOCK (proxy->src);
+  if (proxy->src->switch_proxy != proxy) {
+    GST_OBJECT_UNLOCK (proxy->src);
+    return TRUE;
+  }
+  GST_OBJECT_UNLOCK (proxy->src);
+
+  gst_inter_pipe_src_cancel_switch (proxy->src);
+
+  return TRUE;
+}
+
+static gboolean
+gst_inter_pipe_src_proxy_push_buffer (GstInterPipeIListener * iface,
+    GstBuffer * buffer, guint64 basetime)
+{
+  GstInterPipeSrcProxy *proxy;
+
+  proxy = GST_INTER_PIPE_SRC_PROXY (iface);
+
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    goto drop;
+
+  /* A keyframe replayed while the proxy is being attached. Cutting over
+   * from here would re-enter the registry, so the attach does it */
+  if (proxy->attach_thread == g_thread_self ()) {
+    proxy->cut_pending = TRUE;
+    goto drop;
+  }
+
+  if (!gst_inter_pipe_src_cut_over (proxy->src, proxy, buffer))
+    goto drop;
+
+  return gst_inter_pipe_src_push_buffer (GST_INTER_PIPE_ILISTENER (proxy->src),
+      buffer, basetime);
+
+drop:
+  {
+    GST_LOG_OBJECT (proxy->src, "Dropping buffer %p while waiting for a "
+        "keyframe", buffer);
+    gst_buffer_unref (buffer);
+    return TRUE;
+  }
+}
+
+static gboolean
+gst_inter_pipe_src_proxy_push_event (GstInterPipeIListener * iface,
+    GstEvent * event, guint64 basetime)
+{
+  /* The source still follows the events of its current node */
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static gboolean
+gst_inter_pipe_src_proxy_send_eos (GstInterPipeIListener * iface)
+{
+  return TRUE;
+}
+
+static void
+gst_inter_pipe_src_proxy_ilistener_init (GstInterPipeIListenerInterface *
+    iface)
+{
+  iface->get_name = gst_inter_pipe_src_proxy_get_name;
+  iface->node_added = gst_inter_pipe_src_proxy_node_added;
+  iface->node_removed = gst_inter_pipe_src_proxy_node_removed;
+  iface->get_caps = gst_inter_pipe_src_proxy_get_caps;
+  iface->set_caps = gst_inter_pipe_src_proxy_set_caps;
+  iface->push_buffer = gst_inter_pipe_src_proxy_push_buffer;
+  iface->push_event = gst_inter_pipe_src_proxy_push_event;
+  iface->send_eos = gst_inter_pipe_src_proxy_send_eos;
+}
+
+/* Ring transport */
+static guint
+gst_inter_pipe_src_ring_capacity (guint size)
+{
+  guint capacity = 2;
+
+  while (capacity < size)
+    capacity <<= 1;
+
+  return capacity;
+}
+
+static GstInterPipeSrcRing *
+gst_inter_pipe_src_ring_new (guint size)
+{
+  GstInterPipeSrcRing *ring;
+  guint capacity, i;
+
+  capacity = gst_inter_pipe_src_ring_capacity (size);
+
+  ring = g_new0 (GstInterPipeSrcRing, 1);
+  ring->slots = g_new0 (GstInterPipeSrcRingSlot, capacity);
+  for (i = 0; i < capacity; i++)
+    ring->slots[i].seq = (gint) i;
+  ring->mask = capacity - 1;
+  ring->head = 0;
+  ring->tail = 0;
+  g_queue_init (&ring->overflow);
+  ring->overflowing = 0;
+  g_mutex_init (&ring->overflow_lock);
+  ring->waiting = 0;
+  ring->flushing = 0;
+  g_mutex_init (&ring->wait_lock);
+  g_cond_init (&ring->wait_cond);
+
+  return ring;
+}
+
+/* No producer may be left */
+static void
+gst_inter_pipe_src_ring_free (GstInterPipeSrcRing * ring)
+{
+  gst_inter_pipe_src_ring_clear (ring);
+
+  g_mutex_clear (&ring->overflow_lock);
+  g_mutex_clear (&ring->wait_lock);
+  g_cond_clear (&ring->wait_cond);
+  g_free (ring->slots);
+  g_free (ring);
+}
+
+static guint
+gst_inter_pipe_src_ring_get_capacity (GstInterPipeSrcRing * ring)
+{
+  return ring->mask + 1;
+}
+
+static void
+gst_inter_pipe_src_ring_wake_up (GstInterPipeSrcRing * ring)
+{
+  g_mutex_lock (&ring->wait_lock);
+  g_cond_signal (&ring->wait_cond);
+  g_mutex_unlock (&ring->wait_lock);
+}
+
+/* Takes ownership of @item only if there was room for it */
+static gboolean
+gst_inter_pipe_src_ring_try_push (GstInterPipeSrcRing * ring,
+    GstMiniObject * item)
+{
+  GstInterPipeSrcRingSlot *slot;
+  guint tail, seq;
+
+  tail = (guint) g_atomic_int_get (&ring->tail);
+  for (;;) {
+    slot = &ring->slots[tail & ring->mask];
+    seq = (guint) g_atomic_int_get (&slot->seq);
+
+    if (seq == tail) {
+      if (g_atomic_int_compare_and_exchange (&ring->tail, (gint) tail,
+              (gint) (tail + 1)))
+        break;
+    } else if ((gint) (seq - tail) < 0) {
+      /* Still holds the item of the previous lap */
+      return FALSE;
+    }
+
+    /* Claimed by another producer meanwhile */
+    tail = (guint) g_atomic_int_get (&ring->tail);
+  }
+
+  slot->item = item;
+  g_atomic_int_set (&slot->seq, (gint) (tail + 1));
+
+  return TRUE;
+}
+
+/* Takes ownership of @item. Once an item overflows, the next ones queue
+ * behind it until the consumer drained the ring, so the order holds */
+static void
+gst_inter_pipe_src_ring_push (GstInterPipeSrcRing * ring, GstMiniObject * item)
+{
+  if (!g_atomic_int_get (&ring->overflowing)
+      && gst_inter_pipe_src_ring_try_push (ring, item))
+    goto pushed;
+
+  g_mutex_lock (&ring->overflow_lock);
+  /* The consumer may have drained both meanwhile */
+  if (ring->overflow.length > 0
+      || !gst_inter_pipe_src_ring_try_push (ring, item)) {
+    g_queue_push_tail (&ring->overflow, item);
+    g_atomic_int_set (&ring->overflowing, (gint) ring->overflow.length);
+  }
+  g_mutex_unlock (&ring->overflow_lock);
+
+pushed:
+  if (g_atomic_int_get (&ring->waiting))
+    gst_inter_pipe_src_ring_wake_up (ring);
+}
+
+/* Called by the consumer on an empty ring with items overflowed: hands
+ * out the oldest one and moves as many of the rest as fit in the ring */
+static GstMiniObject *
+gst_inter_pipe_src_ring_refill (GstInterPipeSrcRing * ring)
+{
+  GstMiniObject *item;
+
+  g_mutex_lock (&ring->overflow_lock);
+
+  item = g_queue_pop_head (&ring->overflow);
+  while (ring->overflow.length > 0
+      && gst_inter_pipe_src_ring_try_push (ring,
+          g_queue_peek_head (&ring->overflow)))
+    g_queue_pop_head (&ring->overflow);
+  g_atomic_int_set (&ring->overflowing, (gint) ring->overflow.length);
+
+  g_mutex_unlock (&ring->overflow_lock);
+
+  return item;
+}
+
+static gboolean
+gst_inter_pipe_src_ring_is_published (GstInterPipeSrcRing * ring, guint head)
+{
+  return (guint) g_atomic_int_get (&ring->slots[head & ring->mask].seq) ==
+      head + 1;
+}
+
+/* Nothing goes into the ring while items are overflowed, unless a
+ * producer checked just before, and only the consumer takes them out */
+static gboolean
+gst_inter_pipe_src_ring_must_refill (GstInterPipeSrcRing * ring, guint head)
+{
+  return g_atomic_int_get (&ring->overflowing) > 0
+      && (guint) g_atomic_int_get (&ring->tail) == head;
+}
+
+/* Blocks until an item is available, NULL when flushing */
+static GstMiniObject *
+gst_inter_pipe_src_ring_pop (GstInterPipeSrcRing * ring)
+{
+  GstInterPipeSrcRingSlot *slot;
+  GstMiniObject *item;
+  guint head;
+
+  head = (guint) ring->head;
+
+  while (!gst_inter_pipe_src_ring_is_published (ring, head)) {
+    if (g_atomic_int_get (&ring->flushing))
+      return NULL;
+
+    if (gst_inter_pipe_src_ring_must_refill (ring, head))
+      return gst_inter_pipe_src_ring_refill (ring);
+
+    /* Announce the wait before the last check, so a producer either
+     * sees it or the item is already visible here. A claimed slot not
+     * published yet is waited for too */
+    g_mutex_lock (&ring->wait_lock);
+    g_atomic_int_set (&ring->waiting, 1);
+    while (!g_atomic_int_get (&ring->flushing)
+        && !gst_inter_pipe_src_ring_is_published (ring, head)
+        && !gst_inter_pipe_src_ring_must_refill (ring, head))
+      g_cond_wait (&ring->wait_cond, &ring->wait_lock);
+    g_atomic_int_set (&ring->waiting, 0);
+    g_mutex_unlock (&ring->wait_lock);
+  }
+
+  if (g_atomic_int_get (&ring->flushing))
+    return NULL;
+
+  slot = &ring->slots[head & ring->mask];
+  item = slot->item;
+  slot->item = NULL;
+  /* Free for the producers on the next lap */
+  g_atomic_int_set (&slot->seq, (gint) (head + ring->mask + 1));
+  g_atomic_int_set (&ring->head, (gint) (head + 1));
+
+  return item;
+}
+
+static gboolean
+gst_inter_pipe_src_ring_is_empty (GstInterPipeSrcRing * ring)
+{
+  return g_atomic_int_get (&ring->tail) == g_atomic_int_get (&ring->head)
+      && 0 == g_atomic_int_get (&ring->overflowing);
+}
+
+static void
+gst_inter_pipe_src_ring_set_flushing (GstInterPipeSrcRing * ring,
+    gboolean flushing)
+{
+  g_atomic_int_set (&ring->flushing, flushing);
+  if (flushing)
+    gst_inter_pipe_src_ring_wake_up (ring);
+}
+
+/* Must be called while the streaming thread is stopped. A slot claimed
+ * but not published yet is left to the next session */
+static void
+gst_inter_pipe_src_ring_clear (GstInterPipeSrcRing * ring)
+{
+  GstInterPipeSrcRingSlot *slot;
+  GstMiniObject *item;
+  guint head;
+
+  g_mutex_lock (&ring->overflow_lock);
+
+  head = (guint) ring->head;
+  while (gst_inter_pipe_src_ring_is_published (ring, head)) {
+    slot = &ring->slots[head & ring->mask];
+    gst_mini_object_unref (slot->item);
+    slot->item = NULL;
+    g_atomic_int_set (&slot->seq, (gint) (head + ring->mask + 1));
+    head++;
+  }
+  g_atomic_int_set (&ring->head, (gint) head);
+
+  while ((item = g_queue_pop_head (&ring->overflow)))
+    gst_mini_object_unref (item);
+  g_atomic_int_set (&ring->overflowing, 0);
+
+  g_mutex_unlock (&ring->overflow_lock);
+}
@@ -58,5 +58,36 @@ typedef struct _GstInterPipeSrcClass GstInterPipeSrcClass;
 
 GType gst_inter_pipe_src_get_type (void);
 
+/**
+ * gst_inter_pipe_src_listen_inode:
+ * @src: (transfer none)(not nullable): The interpipesrc to switch
+ * @node: (transfer none)(not nullable): A node handle obtained through
+ * gst_inter_pipe_ref_node()
+ *
+ * Switch @src to @node, same as setting the listen-to property but
+ * without resolving the node name. The listen-to property reflects
+ * the new node afterwards.
+ *
+ * Returns: TRUE if @src is now listening to @node, FALSE otherwise.
+ */
+gboolean gst_inter_pipe_src_listen_inode (GstInterPipeSrc * src,
+    GstInterPipeINode * node);
+
+/**
+ * gst_inter_pipe_src_listen_inodes:
+ * @srcs: (array length=num_srcs)(transfer none): The interpipesrcs to switch
+ * @nodes: (array length=num_srcs)(transfer none): The node handle for
+ * each source
+ * @num_srcs: The number of sources and nodes
+ *
+ * Switch a group of sources in a single registry update, see
+ * gst_inter_pipe_listen_inodes(). Either all the sources are switched
+ * or none is, which also applies when any of them has block-switch set.
+ *
+ * Returns: TRUE if all the sources were switched, FALSE otherwise.
+ */
+gboolean gst_inter_pipe_src_listen_inodes (GstInterPipeSrc ** srcs,
+    GstInterPipeINode ** nodes, guint num_srcs);
+
 G_END_DECLS
 #endif /* __GST_INTER_PIPE_SRC_H__ */
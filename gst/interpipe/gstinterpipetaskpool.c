@@ -0,0 +1,287 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This file is part of gst-interpipe-1.0
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* For pthread_setaffinity_np */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "gstinterpipetaskpool.h"
+
+/**
+ * SECTION:gstinterpipetaskpool
+ * @short_description: Task pool shared by the interpipe elements
+ *
+ * The default #GstTaskPool spawns a new thread for every job and lets
+ * it go afterwards. This one keeps the threads of finished jobs for
+ * the next ones, and may cap how many run at once: the remaining jobs
+ * are then queued and picked by whichever thread frees up first. A
+ * capped pool may also keep its threads to itself, each pinned to a
+ * core.
+ */
+
+GST_DEBUG_CATEGORY_STATIC (gst_inter_pipe_task_pool_debug);
+#define GST_CAT_DEFAULT gst_inter_pipe_task_pool_debug
+
+struct _GstInterPipeTaskPool
+{
+  GstTaskPool parent;
+
+  gint max_threads;
+  gboolean pinned;
+  GThreadPool *threads;
+
+  /* The core the next thread is pinned to */
+  gint next_cpu;
+};
+
+struct _GstInterPipeTaskPoolClass
+{
+  GstTaskPoolClass parent_class;
+};
+
+typedef struct _GstInterPipeTaskPoolJob GstInterPipeTaskPoolJob;
+struct _GstInterPipeTaskPoolJob
+{
+  GstTaskPoolFunction func;
+  gpointer user_data;
+};
+
+static void gst_inter_pipe_task_pool_prepare (GstTaskPool * pool,
+    GError ** error);
+static void gst_inter_pipe_task_pool_cleanup (GstTaskPool * pool);
+static gpointer gst_inter_pipe_task_pool_push (GstTaskPool * pool,
+    GstTaskPoolFunction func, gpointer user_data, GError ** error);
+static void gst_inter_pipe_task_pool_join (GstTaskPool * pool, gpointer id);
+static void gst_inter_pipe_task_pool_run (gpointer data, gpointer user_data);
+static void gst_inter_pipe_task_pool_pin_thread (GstInterPipeTaskPool * self);
+
+G_DEFINE_TYPE (GstInterPipeTaskPool, gst_inter_pipe_task_pool,
+    GST_TYPE_TASK_POOL);
+
+static void
+gst_inter_pipe_task_pool_class_init (GstInterPipeTaskPoolClass * klass)
+{
+  GstTaskPoolClass *pool_class;
+
+  pool_class = GST_TASK_POOL_CLASS (klass);
+
+  pool_class->prepare = gst_inter_pipe_task_pool_prepare;
+  pool_class->cleanup = gst_inter_pipe_task_pool_cleanup;
+  pool_class->push = gst_inter_pipe_task_pool_push;
+  pool_class->join = gst_inter_pipe_task_pool_join;
+
+  GST_DEBUG_CATEGORY_INIT (gst_inter_pipe_task_pool_debug,
+      "interpipetaskpool", 0, "interpipe shared task pool");
+}
+
+static void
+gst_inter_pipe_task_pool_init (GstInterPipeTaskPool * self)
+{
+  self->max_threads = -1;
+  self->pinned = FALSE;
+  self->threads = NULL;
+  self->next_cpu = 0;
+}
+
+static void
+gst_inter_pipe_task_pool_prepare (GstTaskPool * pool, GError ** error)
+{
+  GstInterPipeTaskPool *self;
+  gint max_threads;
+
+  self = GST_INTER_PIPE_TASK_POOL (pool);
+  max_threads = self->max_threads;
+  if (0 == max_threads)
+    max_threads = MAX (g_get_num_processors (), 1);
+
+  GST_INFO_OBJECT (self, "Preparing pool with %d threads at most%s",
+      max_threads, self->pinned ? ", pinned" : "");
+  /* GLib hands idle threads over to other pools, a pinned one must
+   * stay in this one */
+  self->threads = g_thread_pool_new (gst_inter_pipe_task_pool_run, self,
+      max_threads, self->pinned && max_threads > 0, error);
+}
+
+static void
+gst_inter_pipe_task_pool_cleanup (GstTaskPool * pool)
+{
+  GstInterPipeTaskPool *self;
+
+  self = GST_INTER_PIPE_TASK_POOL (pool);
+
+  if (self->threads) {
+    g_thread_pool_free (self->threads, FALSE, TRUE);
+    self->threads = NULL;
+  }
+}
+
+static gpointer
+gst_inter_pipe_task_pool_push (GstTaskPool * pool, GstTaskPoolFunction func,
+    gpointer user_data, GError ** error)
+{
+  GstInterPipeTaskPool *self;
+  GstInterPipeTaskPoolJob *job;
+
+  self = GST_INTER_PIPE_TASK_POOL (pool);
+
+  if (!self->threads)
+    goto not_prepared;
+
+  job = g_slice_new (GstInterPipeTaskPoolJob);
+  job->func = func;
+  job->user_data = user_data;
+
+  if (!g_thread_pool_push (self->threads, job, error)) {
+    g_slice_free (GstInterPipeTaskPoolJob, job);
+    return NULL;
+  }
+
+  /* Jobs are not joinable, the callers wait on their own state */
+  return NULL;
+
+not_prepared:
+  {
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
+        "Task pool not prepared");
+    return NULL;
+  }
+}
+
+static void
+gst_inter_pipe_task_pool_join (GstTaskPool * pool, gpointer id)
+{
+}
+
+/* Set on the threads of a pinned pool once they are pinned */
+static GPrivate gst_inter_pipe_task_pool_thread_pinned;
+
+static void
+gst_inter_pipe_task_pool_pin_thread (GstInterPipeTaskPool * self)
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  cpu_set_t cpuset;
+  gint cpu;
+  gint err;
+
+  cpu = g_atomic_int_add (&self->next_cpu, 1) % MAX (g_get_num_processors (),
+      1);
+
+  CPU_ZERO (&cpuset);
+  CPU_SET (cpu, &cpuset);
+  err = pthread_setaffinity_np (pthread_self (), sizeof (cpuset), &cpuset);
+  if (err)
+    GST_WARNING_OBJECT (self, "Could not pin thread to core %d: %s", cpu,
+        g_strerror (err));
+  else
+    GST_DEBUG_OBJECT (self, "Pinned thread to core %d", cpu);
+#else
+  GST_WARNING_OBJECT (self, "Pinning threads is not supported on this "
+      "platform");
+#endif
+
+  g_private_set (&gst_inter_pipe_task_pool_thread_pinned,
+      GINT_TO_POINTER (TRUE));
+}
+
+static void
+gst_inter_pipe_task_pool_run (gpointer data, gpointer user_data)
+{
+  GstInterPipeTaskPool *self = user_data;
+  GstInterPipeTaskPoolJob *job = data;
+
+  if (G_UNLIKELY (self->pinned
+          && !g_private_get (&gst_inter_pipe_task_pool_thread_pinned)))
+    gst_inter_pipe_task_pool_pin_thread (self);
+
+  job->func (job->user_data);
+  g_slice_free (GstInterPipeTaskPoolJob, job);
+}
+
+gboolean
+gst_inter_pipe_task_pool_has_waiting (GstTaskPool * pool)
+{
+  GstInterPipeTaskPool *self;
+
+  g_return_val_if_fail (GST_IS_INTER_PIPE_TASK_POOL (pool), FALSE);
+
+  self = GST_INTER_PIPE_TASK_POOL (pool);
+
+  return self->threads && g_thread_pool_unprocessed (self->threads) > 0;
+}
+
+void
+gst_inter_pipe_task_pool_set_pinned (GstTaskPool * pool, gboolean pinned)
+{
+  GstInterPipeTaskPool *self;
+
+  g_return_if_fail (GST_IS_INTER_PIPE_TASK_POOL (pool));
+
+  self = GST_INTER_PIPE_TASK_POOL (pool);
+  g_return_if_fail (self->threads == NULL);
+  g_return_if_fail (!pinned || self->max_threads >= 0);
+
+  self->pinned = pinned;
+}
+
+GstTaskPool *
+gst_inter_pipe_task_pool_new (gint max_threads)
+{
+  GstTaskPool *pool;
+
+  g_return_val_if_fail (max_threads >= -1, NULL);
+
+  pool = g_object_new (GST_TYPE_INTER_PIPE_TASK_POOL, NULL);
+  GST_INTER_PIPE_TASK_POOL (pool)->max_threads = max_threads;
+  gst_object_ref_sink (pool);
+
+  return pool;
+}
+
+static gpointer
+gst_inter_pipe_task_pool_create_default (gpointer data)
+{
+  GstTaskPool *pool;
+
+  pool = gst_inter_pipe_task_pool_new (0);
+  gst_task_pool_prepare (pool, NULL);
+
+  return pool;
+}
+
+GstTaskPool *
+gst_inter_pipe_task_pool_get_default (void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, gst_inter_pipe_task_pool_create_default, NULL);
+
+  return once.retval;
+}
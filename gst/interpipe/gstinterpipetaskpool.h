@@ -0,0 +1,102 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This file is part of gst-interpipe-1.0
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_INTER_PIPE_TASK_POOL_H__
+#define __GST_INTER_PIPE_TASK_POOL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_INTER_PIPE_TASK_POOL \
+  (gst_inter_pipe_task_pool_get_type())
+#define GST_INTER_PIPE_TASK_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_INTER_PIPE_TASK_POOL,GstInterPipeTaskPool))
+#define GST_IS_INTER_PIPE_TASK_POOL(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_INTER_PIPE_TASK_POOL))
+
+/**
+ * GstInterPipeTaskPool:
+ *
+ * Opaque #GstInterPipeTaskPool structure.
+ */
+typedef struct _GstInterPipeTaskPool GstInterPipeTaskPool;
+
+/**
+ * GstInterPipeTaskPoolClass:
+ *
+ * Opaque #GstInterPipeTaskPoolClass structure.
+ */
+typedef struct _GstInterPipeTaskPoolClass GstInterPipeTaskPoolClass;
+
+GType gst_inter_pipe_task_pool_get_type (void);
+
+/**
+ * gst_inter_pipe_task_pool_new:
+ * @max_threads: The most threads the pool runs at once, 0 for one per
+ * core or -1 for no limit
+ *
+ * Create a new pool. Jobs pushed while @max_threads of them are running
+ * wait for the first one to finish. Without a limit every job gets a
+ * thread right away, reusing the ones left by finished jobs.
+ *
+ * Returns: (transfer full): A new, not yet prepared, task pool
+ */
+GstTaskPool *gst_inter_pipe_task_pool_new (gint max_threads);
+
+/**
+ * gst_inter_pipe_task_pool_set_pinned:
+ * @pool: (transfer none)(not nullable): A task pool created with
+ * gst_inter_pipe_task_pool_new() with a thread limit, not yet prepared
+ * @pinned: Whether to pin the threads
+ *
+ * Keep the threads of @pool to itself and pin each of them to a core,
+ * round robin, so the jobs keep their caches warm. The threads are
+ * started when the pool is prepared. Without thread affinity support
+ * in the platform the threads are kept but not pinned.
+ */
+void gst_inter_pipe_task_pool_set_pinned (GstTaskPool * pool,
+    gboolean pinned);
+
+/**
+ * gst_inter_pipe_task_pool_has_waiting:
+ * @pool: (transfer none)(not nullable): A task pool created with
+ * gst_inter_pipe_task_pool_new()
+ *
+ * Tell whether jobs are queued waiting for a thread, so the running
+ * ones can hand theirs over.
+ *
+ * Returns: TRUE if any job is waiting for a thread, FALSE otherwise
+ */
+gboolean gst_inter_pipe_task_pool_has_waiting (GstTaskPool * pool);
+
+/**
+ * gst_inter_pipe_task_pool_get_default:
+ *
+ * Get the task pool the interpipesrc streaming tasks share, with one
+ * thread per core. The tasks give their thread back whenever they
+ * would wait, and take turns while other tasks are waiting for one.
+ *
+ * Returns: (transfer none): The shared, already prepared, task pool
+ */
+GstTaskPool *gst_inter_pipe_task_pool_get_default (void);
+
+G_END_DECLS
+#endif /* __GST_INTER_PIPE_TASK_POOL_H__ */
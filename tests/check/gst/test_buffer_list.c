@@ -0,0 +1,125 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+#if GST_CHECK_VERSION(1,14,0)
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given a sink pipeline receiving buffer lists, when a list of three
+ * buffers is pushed then the listener outputs the three buffers in order.
+ */
+GST_START_TEST (interpipe_buffer_list)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstBufferList *list;
+  GstBuffer *buffer;
+  guint64 i;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=application/x-rtp ! "
+          "interpipesink name=listsink async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=listsink ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  /* Push a list of marked packets */
+  list = gst_buffer_list_new ();
+  for (i = 1; i <= 3; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    gst_buffer_list_add (list, buffer);
+  }
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer_list (GST_APP_SRC (asrc),
+          list));
+
+  /* All the packets make it across in order */
+  fail_if (pull_mark (asink) != 1);
+  fail_if (pull_mark (asink) != 2);
+  fail_if (pull_mark (asink) != 3);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+#endif
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("buffer_list");
+
+  suite_add_tcase (suite, tc);
+#if GST_CHECK_VERSION(1,14,0)
+  tcase_add_test (tc, interpipe_buffer_list);
+#endif
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,149 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static GstPadProbeReturn
+record_thread (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  g_atomic_pointer_set ((gpointer *) user_data, g_thread_self ());
+
+  return GST_PAD_PROBE_OK;
+}
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given a source in direct push mode, when buffers are pushed one at a
+ * time then they arrive in order and, once the source is idle, they
+ * reach downstream from the thread of the node.
+ */
+GST_START_TEST (interpipe_direct_push)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstElement *intersink;
+  GstPad *pad;
+  GstBuffer *buffer;
+  gpointer node_thread = NULL;
+  gpointer sink_thread = NULL;
+  guint64 i;
+  guint direct = 0;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=directsink async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+  intersink = gst_bin_get_by_name (GST_BIN (sink), "directsink");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=directsink direct-push=true ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  pad = gst_element_get_static_pad (intersink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, record_thread,
+      &node_thread, NULL);
+  gst_object_unref (pad);
+
+  pad = gst_element_get_static_pad (asink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, record_thread,
+      &sink_thread, NULL);
+  gst_object_unref (pad);
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  /* The first buffer carries caps and segment through the streaming
+   * thread, the following ones may skip it */
+  for (i = 1; i <= 10; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+            buffer));
+    fail_if (pull_mark (asink) != i);
+
+    if (g_atomic_pointer_get (&node_thread) ==
+        g_atomic_pointer_get (&sink_thread))
+      direct++;
+
+    /* Let the streaming thread go back to idle */
+    g_usleep (10000);
+  }
+  fail_unless (direct > 0);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (intersink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("direct_push");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_direct_push);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,152 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static void
+push_marked_buffer (GstElement * asrc, guint64 mark)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_OFFSET (buffer) = mark;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+}
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given a source with flush-on-switch and buffers from the first node
+ * waiting in its queue, when it switches to the second node then the
+ * first buffer that comes out after the ones already downstream is
+ * from the second node.
+ */
+GST_START_TEST (interpipe_flush_on_switch)
+{
+  GstPipeline *sink1;
+  GstPipeline *sink2;
+  GstPipeline *src;
+  GstElement *asrc1;
+  GstElement *asrc2;
+  GstElement *asink;
+  GstElement *intersrc;
+  guint64 i;
+  GError *error = NULL;
+
+  /* Create two sink pipelines */
+  sink1 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=flushsink1 async=false", &error));
+  fail_if (error);
+  asrc1 = gst_bin_get_by_name (GST_BIN (sink1), "asrc");
+
+  sink2 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=flushsink2 async=false", &error));
+  fail_if (error);
+  asrc2 = gst_bin_get_by_name (GST_BIN (sink2), "asrc");
+
+  /* Create the source pipeline, appsink holds a single sample */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=flushsink1 flush-on-switch=true ! "
+          "appsink name=asink async=false sync=false max-buffers=1 drop=false",
+          &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  /* The first one waits in appsink, the streaming thread blocks on the
+   * second one and the rest stay queued */
+  push_marked_buffer (asrc1, 1);
+  g_usleep (50000);
+  push_marked_buffer (asrc1, 2);
+  g_usleep (50000);
+  for (i = 3; i <= 5; i++)
+    push_marked_buffer (asrc1, i);
+  g_usleep (50000);
+
+  g_object_set (G_OBJECT (intersrc), "listen-to", "flushsink2", NULL);
+  push_marked_buffer (asrc2, 100);
+
+  fail_if (pull_mark (asink) != 1);
+  fail_if (pull_mark (asink) != 2);
+  fail_if (pull_mark (asink) != 100);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc1);
+  g_object_unref (asrc2);
+  g_object_unref (asink);
+  g_object_unref (intersrc);
+  g_object_unref (sink1);
+  g_object_unref (sink2);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("flush_on_switch");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_flush_on_switch);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,149 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static void
+push_marked_buffer (GstElement * asrc, guint64 mark, gboolean delta)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_OFFSET (buffer) = mark;
+  if (delta)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+}
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given a node with the GOP cache enabled that already delivered a
+ * keyframe and two delta units, when a source switches to it then the
+ * source starts with the cached GOP, followed by the live buffers.
+ */
+GST_START_TEST (interpipe_gop_cache)
+{
+  GstPipeline *sink1;
+  GstPipeline *sink2;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstElement *intersrc;
+  GError *error = NULL;
+
+  /* Create the caching sink pipeline and an idle one */
+  sink1 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=gopsink1 gop-cache=true async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink1), "asrc");
+
+  sink2 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=gopsink2 async=false", &error));
+  fail_if (error);
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=gopsink2 ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  /* A delta unit without its keyframe is not cached */
+  push_marked_buffer (asrc, 1, TRUE);
+  push_marked_buffer (asrc, 2, FALSE);
+  push_marked_buffer (asrc, 3, TRUE);
+  push_marked_buffer (asrc, 4, TRUE);
+
+  /* The late listener gets the current GOP right away */
+  g_object_set (G_OBJECT (intersrc), "listen-to", "gopsink1", NULL);
+  fail_if (pull_mark (asink) != 2);
+  fail_if (pull_mark (asink) != 3);
+  fail_if (pull_mark (asink) != 4);
+
+  /* And the live buffers after it */
+  push_marked_buffer (asrc, 5, TRUE);
+  fail_if (pull_mark (asink) != 5);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (intersrc);
+  g_object_unref (sink1);
+  g_object_unref (sink2);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("gop_cache");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_gop_cache);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
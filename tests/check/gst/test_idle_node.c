@@ -0,0 +1,149 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+static gboolean
+pop_idle (GstPipeline * pipeline)
+{
+  GstBus *bus;
+  GstMessage *message;
+  const GstStructure *structure;
+  gboolean idle = FALSE;
+
+  bus = gst_pipeline_get_bus (pipeline);
+  message =
+      gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND, GST_MESSAGE_ELEMENT);
+  fail_if (!message);
+
+  structure = gst_message_get_structure (message);
+  fail_unless (gst_structure_has_name (structure, "GstInterPipeSinkIdle"));
+  fail_unless (gst_structure_get_boolean (structure, "idle", &idle));
+
+  gst_message_unref (message);
+  gst_object_unref (bus);
+
+  return idle;
+}
+
+/*
+ * Given a node blocking without listeners, when buffers arrive before
+ * anybody listens then they are held upstream instead of discarded, and
+ * the first listener receives all of them in order.
+ */
+GST_START_TEST (interpipe_idle_node_block)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstBuffer *buffer;
+  guint64 i;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=idlesink block-without-listeners=true "
+          "async=false sync=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=idlesink ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Nobody listens yet, the node goes idle */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_unless (pop_idle (sink));
+
+  for (i = 1; i <= 5; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+            buffer));
+  }
+
+  /* Give a discarding node the chance to drop them */
+  g_usleep (50000);
+
+  /* The listener resumes the producer and gets everything */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+  fail_if (pop_idle (sink));
+  for (i = 1; i <= 5; i++)
+    fail_if (pull_mark (asink) != i);
+
+  /* Losing the last listener blocks again */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_unless (pop_idle (sink));
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("idle_node");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_idle_node_block);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -135,6 +135,109 @@ GST_START_TEST (interpipe_in_bounds_events)
 
 GST_END_TEST;
 
+static gint custom_events;
+static gint events_before_last;
+
+static GstPadProbeReturn
+count_events (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER)
+    g_atomic_int_set (&events_before_last,
+        g_atomic_int_get (&custom_events));
+  else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+      GST_EVENT_CUSTOM_DOWNSTREAM)
+    g_atomic_int_inc (&custom_events);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/*
+ * Given a burst of serialized events between two buffers, when the
+ * second buffer is dequeued then all the events are released before
+ * it and not one per buffer.
+ */
+GST_START_TEST (interpipe_in_bounds_events_burst)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstSample *outsample;
+  GstBuffer *buffer;
+  GstPad *pad;
+  gint i;
+  GError *error = NULL;
+
+  custom_events = 0;
+  events_before_last = 0;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc format=time caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=burstsink sync=false async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=burstsink format=time ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  pad = gst_element_get_static_pad (asink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, count_events, NULL, NULL);
+  gst_object_unref (pad);
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = GST_SECOND;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  gst_sample_unref (outsample);
+
+  /* A burst of events, then the next buffer */
+  pad = gst_element_get_static_pad (asrc, "src");
+  for (i = 0; i < 3; i++)
+    fail_unless (gst_pad_push_event (pad,
+            gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM, NULL)));
+  gst_object_unref (pad);
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = GST_SECOND + 40 * GST_MSECOND;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  gst_sample_unref (outsample);
+
+  fail_if (g_atomic_int_get (&events_before_last) != 3);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_interpipe_suite (void)
 {
@@ -144,6 +247,7 @@ gst_interpipe_suite (void)
   tcase_set_timeout (tc, 40);
   suite_add_tcase (suite, tc);
   tcase_add_test (tc, interpipe_in_bounds_events);
+  tcase_add_test (tc, interpipe_in_bounds_events_burst);
 
   return suite;
 }
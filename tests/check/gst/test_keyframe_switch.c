@@ -0,0 +1,154 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static void
+push_marked_buffer (GstElement * asrc, guint64 mark, gboolean delta)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_OFFSET (buffer) = mark;
+  if (delta)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+}
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given a source in keyframe switch mode, when I switch to a node that
+ * only delivers delta units then the source keeps the old node, and
+ * when the new node delivers a keyframe the source switches over
+ * starting with it.
+ */
+GST_START_TEST (interpipe_keyframe_switch)
+{
+  GstPipeline *sink1;
+  GstPipeline *sink2;
+  GstPipeline *src;
+  GstElement *asrc1;
+  GstElement *asrc2;
+  GstElement *asink;
+  GstElement *intersrc;
+  GError *error = NULL;
+
+  /* Create two sink pipelines */
+  sink1 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc1 caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=kfsink1 async=false", &error));
+  fail_if (error);
+  asrc1 = gst_bin_get_by_name (GST_BIN (sink1), "asrc1");
+
+  sink2 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc2 caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=kfsink2 async=false", &error));
+  fail_if (error);
+  asrc2 = gst_bin_get_by_name (GST_BIN (sink2), "asrc2");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=kfsink1 switch-mode=keyframe ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  push_marked_buffer (asrc1, 1, FALSE);
+  fail_if (pull_mark (asink) != 1);
+
+  g_object_set (G_OBJECT (intersrc), "listen-to", "kfsink2", NULL);
+
+  /* Delta units from the new node are dropped, the old one still flows */
+  push_marked_buffer (asrc2, 2, TRUE);
+  push_marked_buffer (asrc1, 3, TRUE);
+  fail_if (pull_mark (asink) != 3);
+
+  /* The keyframe cuts over, the old node no longer reaches the source */
+  push_marked_buffer (asrc2, 4, FALSE);
+  fail_if (pull_mark (asink) != 4);
+  push_marked_buffer (asrc1, 5, TRUE);
+  push_marked_buffer (asrc2, 6, TRUE);
+  fail_if (pull_mark (asink) != 6);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc1);
+  g_object_unref (asrc2);
+  g_object_unref (asink);
+  g_object_unref (intersrc);
+  g_object_unref (sink1);
+  g_object_unref (sink2);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("keyframe_switch");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_keyframe_switch);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,302 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/video/gstvideometa.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+/*
+ * Given an interpipesink with per listener queues and two listeners, when
+ * one of the listeners stops consuming buffers then the other one keeps
+ * receiving them.
+ */
+GST_START_TEST (interpipe_listener_queue_slow_listener)
+{
+  GstPipeline *sink;
+  GstPipeline *src1;
+  GstPipeline *src2;
+  GstElement *intersink;
+  GstElement *asink1;
+  GstSample *outsample;
+  guint queue_size;
+  gint i;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("videotestsrc is-live=true ! capsfilter caps=video/x-raw,width=320,height=240,framerate=(fraction)30/1 ! interpipesink "
+          "name=intersink listener-queue-size=2 listener-queue-leaky=downstream "
+          "async=false", &error));
+  fail_if (error);
+  intersink = gst_bin_get_by_name (GST_BIN (sink), "intersink");
+
+  g_object_get (G_OBJECT (intersink), "listener-queue-size", &queue_size,
+      NULL);
+  fail_if (queue_size != 2);
+
+  /* Create the source pipelines, the second one is never consumed */
+  src1 =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=intersink ! "
+          "appsink name=asink1 async=false sync=false", &error));
+  fail_if (error);
+  asink1 = gst_bin_get_by_name (GST_BIN (src1), "asink1");
+
+  src2 =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=intersink block=true ! "
+          "appsink name=asink2 async=false sync=false max-buffers=1", &error));
+  fail_if (error);
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_get_state (GST_ELEMENT (sink), NULL, NULL,
+          GST_CLOCK_TIME_NONE));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (src1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (src2), GST_STATE_PLAYING));
+
+  /* The blocked listener does not stall the other one */
+  for (i = 0; i < 30; i++) {
+    outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink1));
+    fail_if (!outsample);
+    fail_if (!gst_sample_get_buffer (outsample));
+    gst_sample_unref (outsample);
+  }
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (src1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (src2), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (intersink);
+  g_object_unref (asink1);
+  g_object_unref (sink);
+  g_object_unref (src1);
+  g_object_unref (src2);
+}
+
+GST_END_TEST;
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given an interpipesink delivering from the shared workers, when a
+ * burst of buffers is rendered then every listener receives all of
+ * them in order.
+ */
+GST_START_TEST (interpipe_listener_queue_shared_delivery)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asinks[3];
+  GstBuffer *buffer;
+  gchar *name;
+  guint64 i;
+  gint j;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=sharedsink shared-delivery=true async=false "
+          "sync=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline with three listeners */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=sharedsink ! "
+          "appsink name=asink0 async=false sync=false "
+          "interpipesrc listen-to=sharedsink ! "
+          "appsink name=asink1 async=false sync=false "
+          "interpipesrc listen-to=sharedsink ! "
+          "appsink name=asink2 async=false sync=false", &error));
+  fail_if (error);
+  for (j = 0; j < 3; j++) {
+    name = g_strdup_printf ("asink%d", j);
+    asinks[j] = gst_bin_get_by_name (GST_BIN (src), name);
+    g_free (name);
+  }
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  for (i = 1; i <= 50; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+            buffer));
+  }
+
+  for (j = 0; j < 3; j++)
+    for (i = 1; i <= 50; i++)
+      fail_if (pull_mark (asinks[j]) != i);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  for (j = 0; j < 3; j++)
+    g_object_unref (asinks[j]);
+  g_object_unref (asrc);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+/*
+ * Given an interpipesink delivering from the shared workers and blocked
+ * listeners holding all the workers but one, when a burst of buffers is
+ * rendered then the other listener still receives all of them in order.
+ */
+GST_START_TEST (interpipe_listener_queue_shared_blocked_listeners)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstPipeline **blocked;
+  GstElement *asrc;
+  GstElement *asink;
+  GstBuffer *buffer;
+  guint num_blocked;
+  guint64 i;
+  guint j;
+  GError *error = NULL;
+
+  /* One worker per core, at least one of them is left free */
+  num_blocked = MAX (g_get_num_processors (), 1) - 1;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=blockingsink shared-delivery=true async=false "
+          "sync=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=blockingsink ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Never consumed, the pushes into them block once a buffer is queued */
+  blocked = g_new0 (GstPipeline *, num_blocked);
+  for (j = 0; j < num_blocked; j++) {
+    blocked[j] =
+        GST_PIPELINE (gst_parse_launch
+        ("interpipesrc listen-to=blockingsink block=true max-bytes=1 ! "
+            "appsink async=false sync=false max-buffers=1", &error));
+    fail_if (error);
+  }
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  for (j = 0; j < num_blocked; j++)
+    fail_if (GST_STATE_CHANGE_FAILURE ==
+        gst_element_set_state (GST_ELEMENT (blocked[j]), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  for (i = 1; i <= 50; i++) {
+    buffer = gst_buffer_new_allocate (NULL, 16, NULL);
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+            buffer));
+  }
+
+  for (i = 1; i <= 50; i++)
+    fail_if (pull_mark (asink) != i);
+
+  /* Stopping the blocked listeners releases their workers */
+  for (j = 0; j < num_blocked; j++) {
+    fail_if (GST_STATE_CHANGE_FAILURE ==
+        gst_element_set_state (GST_ELEMENT (blocked[j]), GST_STATE_NULL));
+    g_object_unref (blocked[j]);
+  }
+  g_free (blocked);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asink);
+  g_object_unref (asrc);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("listener_queue");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_listener_queue_slow_listener);
+  tcase_add_test (tc, interpipe_listener_queue_shared_delivery);
+  tcase_add_test (tc, interpipe_listener_queue_shared_blocked_listeners);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
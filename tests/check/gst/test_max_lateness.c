@@ -0,0 +1,137 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static void
+push_marked_buffer (GstElement * asrc, guint64 mark, GstClockTime pts)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_OFFSET (buffer) = mark;
+  GST_BUFFER_PTS (buffer) = pts;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+}
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given a source with max-lateness, when a buffer arrives with a
+ * running time already behind the clock by more than that, then it is
+ * dropped and counted, and a buffer on time still goes through.
+ */
+GST_START_TEST (interpipe_max_lateness)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstElement *intersrc;
+  GstClock *clock;
+  GstClockTime now;
+  guint64 dropped;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=latesink async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=latesink max-lateness=50000000 ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  g_usleep (200000);
+
+  /* Running time 0 is 200 ms behind by now */
+  push_marked_buffer (asrc, 1, 0);
+
+  clock = gst_element_get_clock (intersrc);
+  fail_if (!clock);
+  now = gst_clock_get_time (clock) - gst_element_get_base_time (intersrc);
+  gst_object_unref (clock);
+  push_marked_buffer (asrc, 2, now + GST_SECOND);
+
+  fail_if (pull_mark (asink) != 2);
+
+  g_object_get (G_OBJECT (intersrc), "dropped-late", &dropped, NULL);
+  fail_if (dropped != 1);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (intersrc);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("max_lateness");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_max_lateness);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,212 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+#include "gst/interpipe/gstinterpipesrc.h"
+
+/*
+ * Given two sink pipelines, when I resolve the second node into a
+ * handle and switch the source to it, then the listen-to property
+ * follows the switch.
+ */
+GST_START_TEST (interpipe_node_handle_switch)
+{
+  GstPipeline *sink1;
+  GstPipeline *sink2;
+  GstPipeline *src;
+  GstElement *intersrc;
+  GstInterPipeINode *node;
+  gchar *node_name;
+  gchar *listen_to;
+  GError *error = NULL;
+
+  /* Create two sink pipelines */
+  sink1 =
+      GST_PIPELINE (gst_parse_launch
+      ("videotestsrc ! capsfilter caps=video/x-raw,width=320,height=240,framerate=(fraction)30/1 ! interpipesink "
+          "name=handlesink1 async=false", &error));
+  fail_if (error);
+
+  sink2 =
+      GST_PIPELINE (gst_parse_launch
+      ("videotestsrc ! capsfilter caps=video/x-raw,width=320,height=240,framerate=(fraction)30/1 ! interpipesink "
+          "name=handlesink2 async=false", &error));
+  fail_if (error);
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=handlesink1 ! "
+          "appsink async=false sync=false", &error));
+  fail_if (error);
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+
+  /* Unknown names don't resolve */
+  fail_if (gst_inter_pipe_ref_node ("handlesink3") != NULL);
+
+  node = gst_inter_pipe_ref_node ("handlesink2");
+  fail_if (node == NULL);
+  node_name = gst_inter_pipe_get_node_name (node);
+  fail_if (g_strcmp0 (node_name, "handlesink2") != 0);
+  g_free (node_name);
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  /* Switch through the handle */
+  fail_unless (gst_inter_pipe_src_listen_inode (GST_INTER_PIPE_SRC (intersrc),
+          node));
+  g_object_get (G_OBJECT (intersrc), "listen-to", &listen_to, NULL);
+  fail_if (g_strcmp0 (listen_to, "handlesink2") != 0);
+  g_free (listen_to);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (node);
+  g_object_unref (intersrc);
+  g_object_unref (sink1);
+  g_object_unref (sink2);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+/*
+ * Given two sources listening to the same node, when I switch both in
+ * one batch then both follow, and when one of them blocks switching
+ * then none of them moves.
+ */
+GST_START_TEST (interpipe_node_handle_batch_switch)
+{
+  GstPipeline *sink1;
+  GstPipeline *sink2;
+  GstPipeline *src;
+  GstInterPipeSrc *srcs[2];
+  GstInterPipeINode *nodes[2];
+  gchar *listen_to;
+  GError *error = NULL;
+
+  /* Create two sink pipelines */
+  sink1 =
+      GST_PIPELINE (gst_parse_launch
+      ("videotestsrc ! capsfilter caps=video/x-raw,width=320,height=240,framerate=(fraction)30/1 ! interpipesink "
+          "name=batchsink1 async=false", &error));
+  fail_if (error);
+
+  sink2 =
+      GST_PIPELINE (gst_parse_launch
+      ("videotestsrc ! capsfilter caps=video/x-raw,width=320,height=240,framerate=(fraction)30/1 ! interpipesink "
+          "name=batchsink2 async=false", &error));
+  fail_if (error);
+
+  /* Create the source pipeline with two sources */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc1 listen-to=batchsink1 ! "
+          "appsink async=false sync=false "
+          "interpipesrc name=intersrc2 listen-to=batchsink1 ! "
+          "appsink async=false sync=false", &error));
+  fail_if (error);
+  srcs[0] =
+      GST_INTER_PIPE_SRC (gst_bin_get_by_name (GST_BIN (src), "intersrc1"));
+  srcs[1] =
+      GST_INTER_PIPE_SRC (gst_bin_get_by_name (GST_BIN (src), "intersrc2"));
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  nodes[0] = gst_inter_pipe_ref_node ("batchsink2");
+  nodes[1] = gst_inter_pipe_ref_node ("batchsink2");
+  fail_if (nodes[0] == NULL);
+
+  /* A blocked source makes the whole batch fail */
+  g_object_set (G_OBJECT (srcs[1]), "block-switch", TRUE, NULL);
+  fail_if (gst_inter_pipe_src_listen_inodes (srcs, nodes, 2));
+  g_object_get (G_OBJECT (srcs[0]), "listen-to", &listen_to, NULL);
+  fail_if (g_strcmp0 (listen_to, "batchsink1") != 0);
+  g_free (listen_to);
+
+  /* Both sources switch together */
+  g_object_set (G_OBJECT (srcs[1]), "block-switch", FALSE, NULL);
+  fail_unless (gst_inter_pipe_src_listen_inodes (srcs, nodes, 2));
+  g_object_get (G_OBJECT (srcs[0]), "listen-to", &listen_to, NULL);
+  fail_if (g_strcmp0 (listen_to, "batchsink2") != 0);
+  g_free (listen_to);
+  g_object_get (G_OBJECT (srcs[1]), "listen-to", &listen_to, NULL);
+  fail_if (g_strcmp0 (listen_to, "batchsink2") != 0);
+  g_free (listen_to);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (nodes[0]);
+  g_object_unref (nodes[1]);
+  g_object_unref (srcs[0]);
+  g_object_unref (srcs[1]);
+  g_object_unref (sink1);
+  g_object_unref (sink2);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("node_handle");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_node_handle_switch);
+  tcase_add_test (tc, interpipe_node_handle_batch_switch);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,159 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static void
+push_marked_buffer (GstElement * asrc, guint64 mark)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_OFFSET (buffer) = mark;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+}
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/* Stalls the source on its second buffer, then floods its queue with
+ * buffers 3 to 10 and checks which ones get through */
+static void
+run_queue_policy (const gchar * leaky, const guint64 * expected,
+    guint num_expected)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  gchar *desc;
+  guint64 i;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=policysink async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline, appsink holds a single sample */
+  desc = g_strdup_printf ("interpipesrc listen-to=policysink "
+      "queue-max-buffers=2 queue-leaky=%s ! appsink name=asink async=false "
+      "sync=false max-buffers=1 drop=false", leaky);
+  src = GST_PIPELINE (gst_parse_launch (desc, &error));
+  g_free (desc);
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  /* The first one waits in appsink, the streaming thread blocks on the
+   * second one */
+  push_marked_buffer (asrc, 1);
+  g_usleep (50000);
+  push_marked_buffer (asrc, 2);
+  g_usleep (50000);
+
+  for (i = 3; i <= 10; i++)
+    push_marked_buffer (asrc, i);
+
+  for (i = 0; i < num_expected; i++)
+    fail_if (pull_mark (asink) != expected[i]);
+
+  /* Nothing else was queued */
+  push_marked_buffer (asrc, 11);
+  fail_if (pull_mark (asink) != 11);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+/*
+ * Given a source with a two buffers queue leaky on upstream, when its
+ * streaming thread is stalled then the newest buffers are dropped.
+ */
+GST_START_TEST (interpipe_queue_policy_upstream)
+{
+  const guint64 expected[] = { 1, 2, 3, 4 };
+
+  run_queue_policy ("upstream", expected, G_N_ELEMENTS (expected));
+}
+
+GST_END_TEST;
+
+/*
+ * Given a source with a two buffers queue leaky on downstream, when its
+ * streaming thread is stalled then the oldest buffers are dropped as it
+ * catches up, and new buffers are dropped past twice the limit.
+ */
+GST_START_TEST (interpipe_queue_policy_downstream)
+{
+  const guint64 expected[] = { 1, 2, 5, 6 };
+
+  run_queue_policy ("downstream", expected, G_N_ELEMENTS (expected));
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("queue_policy");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_queue_policy_upstream);
+  tcase_add_test (tc, interpipe_queue_policy_downstream);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,138 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static void
+push_marked_buffer (GstElement * asrc, guint64 mark)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_OFFSET (buffer) = mark;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+}
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given a source using the ring transport, when buffers are pushed
+ * one at a time, in a burst that fits the ring and in a burst that
+ * overflows it, then they all arrive in order, and the source can be
+ * restarted and used again.
+ */
+GST_START_TEST (interpipe_ring_transport)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  guint64 i;
+  gint run;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=ringsink async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=ringsink transport=ring ring-size=30 ! "
+          "appsink name=asink async=false sync=false max-buffers=1", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+
+  for (run = 0; run < 2; run++) {
+    fail_if (GST_STATE_CHANGE_FAILURE ==
+        gst_element_set_state (GST_ELEMENT (src), GST_STATE_PLAYING));
+
+    /* One at a time, the streaming thread sleeps in between */
+    for (i = 1; i <= 5; i++) {
+      push_marked_buffer (asrc, i);
+      fail_if (pull_mark (asink) != i);
+    }
+
+    /* A burst, fits the ring rounded up to 32 */
+    for (i = 6; i <= 25; i++)
+      push_marked_buffer (asrc, i);
+    for (i = 6; i <= 25; i++)
+      fail_if (pull_mark (asink) != i);
+
+    /* Downstream is stuck meanwhile, so the rest overflows the ring */
+    for (i = 26; i <= 125; i++)
+      push_marked_buffer (asrc, i);
+    for (i = 26; i <= 125; i++)
+      fail_if (pull_mark (asink) != i);
+
+    fail_if (GST_STATE_CHANGE_FAILURE ==
+        gst_element_set_state (GST_ELEMENT (src), GST_STATE_NULL));
+  }
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("ring_transport");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_ring_transport);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,247 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+/*
+ * Given two sink pipelines, when I schedule a switch at a running time
+ * already reached then the source moves to the new node on the next
+ * buffer and keeps producing.
+ */
+GST_START_TEST (interpipe_scheduled_switch)
+{
+  GstPipeline *sink1;
+  GstPipeline *sink2;
+  GstPipeline *src;
+  GstElement *intersrc;
+  GstElement *asink;
+  GstSample *outsample;
+  gboolean scheduled = FALSE;
+  gchar *listen_to;
+  gint i;
+  GError *error = NULL;
+
+  /* Create two sink pipelines */
+  sink1 =
+      GST_PIPELINE (gst_parse_launch
+      ("videotestsrc is-live=true ! capsfilter caps=video/x-raw,width=320,height=240,framerate=(fraction)30/1 ! interpipesink "
+          "name=schedsink1 async=false", &error));
+  fail_if (error);
+
+  sink2 =
+      GST_PIPELINE (gst_parse_launch
+      ("videotestsrc is-live=true ! capsfilter caps=video/x-raw,width=320,height=240,framerate=(fraction)30/1 ! interpipesink "
+          "name=schedsink2 async=false", &error));
+  fail_if (error);
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=schedsink1 is-live=true ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  gst_sample_unref (outsample);
+
+  g_signal_emit_by_name (intersrc, "schedule-switch", "schedsink2",
+      (guint64) 0, &scheduled);
+  fail_unless (scheduled);
+
+  /* The switch happens on the next buffer from the current node */
+  for (i = 0; i < 10; i++) {
+    outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+    fail_if (!outsample);
+    gst_sample_unref (outsample);
+  }
+
+  g_object_get (G_OBJECT (intersrc), "listen-to", &listen_to, NULL);
+  fail_if (g_strcmp0 (listen_to, "schedsink2") != 0);
+  g_free (listen_to);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (intersrc);
+  g_object_unref (asink);
+  g_object_unref (sink1);
+  g_object_unref (sink2);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static void
+push_marked_buffer (GstElement * appsrc, guint64 mark)
+{
+  GstBuffer *buffer;
+
+  /* Far enough ahead for the running time to be past the switch time */
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = 10 * GST_SECOND + mark * GST_MSECOND;
+  GST_BUFFER_OFFSET (buffer) = mark;
+  fail_unless (GST_FLOW_OK ==
+      gst_app_src_push_buffer (GST_APP_SRC (appsrc), buffer));
+}
+
+static void
+pull_marked_buffer (GstElement * appsink, guint64 mark)
+{
+  GstSample *sample;
+
+  sample = gst_app_sink_pull_sample (GST_APP_SINK (appsink));
+  fail_if (!sample);
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (gst_sample_get_buffer
+          (sample)), mark);
+  gst_sample_unref (sample);
+}
+
+/*
+ * Given two sink pipelines, when I schedule a switch then the buffer that
+ * triggers it still reaches the source and the next buffer comes from the
+ * new node.
+ */
+GST_START_TEST (interpipe_scheduled_switch_keeps_trigger)
+{
+  GstPipeline *sink1;
+  GstPipeline *sink2;
+  GstPipeline *src;
+  GstElement *asrc1;
+  GstElement *asrc2;
+  GstElement *intersrc;
+  GstElement *asink;
+  gboolean scheduled = FALSE;
+  gboolean switched = FALSE;
+  gchar *listen_to;
+  gint i;
+  GError *error = NULL;
+
+  /* Create two sink pipelines */
+  sink1 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc1 is-live=true format=time caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=trigsink1 async=false sync=false", &error));
+  fail_if (error);
+
+  sink2 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc2 is-live=true format=time caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=trigsink2 async=false sync=false", &error));
+  fail_if (error);
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=trigsink1 is-live=true "
+          "format=time ! appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asrc1 = gst_bin_get_by_name (GST_BIN (sink1), "asrc1");
+  asrc2 = gst_bin_get_by_name (GST_BIN (sink2), "asrc2");
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  push_marked_buffer (asrc1, 1);
+  pull_marked_buffer (asink, 1);
+
+  g_signal_emit_by_name (intersrc, "schedule-switch", "trigsink2",
+      (guint64) 0, &scheduled);
+  fail_unless (scheduled);
+
+  /* The buffer that triggers the switch is not lost */
+  push_marked_buffer (asrc1, 2);
+  pull_marked_buffer (asink, 2);
+
+  /* The switch completes off the streaming thread */
+  for (i = 0; i < 500 && !switched; i++) {
+    g_object_get (G_OBJECT (intersrc), "listen-to", &listen_to, NULL);
+    switched = 0 == g_strcmp0 (listen_to, "trigsink2");
+    g_free (listen_to);
+    if (!switched)
+      g_usleep (10000);
+  }
+  fail_unless (switched);
+
+  push_marked_buffer (asrc2, 3);
+  pull_marked_buffer (asink, 3);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc1);
+  g_object_unref (asrc2);
+  g_object_unref (intersrc);
+  g_object_unref (asink);
+  g_object_unref (sink1);
+  g_object_unref (sink2);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("scheduled_switch");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_scheduled_switch);
+  tcase_add_test (tc, interpipe_scheduled_switch_keeps_trigger);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
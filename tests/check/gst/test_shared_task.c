@@ -0,0 +1,223 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given two sources running on the shared task pool, when buffers
+ * arrive after the sources went idle then both wake up and deliver
+ * them in order, and EOS still makes it downstream.
+ */
+GST_START_TEST (interpipe_shared_task)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink1;
+  GstElement *asink2;
+  GstBuffer *buffer;
+  guint64 i;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=sharedsink async=false sync=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline, one source on each transport */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=sharedsink shared-task=true ! "
+          "appsink name=asink1 async=false sync=false "
+          "interpipesrc listen-to=sharedsink shared-task=true transport=ring ! "
+          "appsink name=asink2 async=false sync=false", &error));
+  fail_if (error);
+  asink1 = gst_bin_get_by_name (GST_BIN (src), "asink1");
+  asink2 = gst_bin_get_by_name (GST_BIN (src), "asink2");
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  for (i = 1; i <= 10; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+            buffer));
+    fail_if (pull_mark (asink1) != i);
+    fail_if (pull_mark (asink2) != i);
+
+    /* Let the tasks park */
+    g_usleep (10000);
+  }
+
+  /* A burst is delivered in one go */
+  for (i = 11; i <= 20; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+            buffer));
+  }
+  for (i = 11; i <= 20; i++) {
+    fail_if (pull_mark (asink1) != i);
+    fail_if (pull_mark (asink2) != i);
+  }
+
+  /* EOS wakes up the parked tasks as well */
+  g_usleep (10000);
+  fail_if (GST_FLOW_OK != gst_app_src_end_of_stream (GST_APP_SRC (asrc)));
+  fail_if (gst_app_sink_pull_sample (GST_APP_SINK (asink1)) != NULL);
+  fail_unless (gst_app_sink_is_eos (GST_APP_SINK (asink1)));
+  fail_if (gst_app_sink_pull_sample (GST_APP_SINK (asink2)) != NULL);
+  fail_unless (gst_app_sink_is_eos (GST_APP_SINK (asink2)));
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink1);
+  g_object_unref (asink2);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+/*
+ * Given more sources on the shared task pool than it has threads, when
+ * a burst keeps all of them busy then they take turns on the threads
+ * and every source delivers all of it in order.
+ */
+GST_START_TEST (interpipe_shared_task_turns)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement **asinks;
+  GstBuffer *buffer;
+  GString *desc;
+  gchar *name;
+  guint num_srcs;
+  guint64 i;
+  guint j;
+  GError *error = NULL;
+
+  num_srcs = 2 * g_get_num_processors () + 1;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=turnsink async=false sync=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  desc = g_string_new (NULL);
+  for (j = 0; j < num_srcs; j++)
+    g_string_append_printf (desc,
+        "interpipesrc listen-to=turnsink shared-task=true ! "
+        "appsink name=asink%u async=false sync=false ", j);
+  src = GST_PIPELINE (gst_parse_launch (desc->str, &error));
+  fail_if (error);
+  g_string_free (desc, TRUE);
+
+  asinks = g_new (GstElement *, num_srcs);
+  for (j = 0; j < num_srcs; j++) {
+    name = g_strdup_printf ("asink%u", j);
+    asinks[j] = gst_bin_get_by_name (GST_BIN (src), name);
+    g_free (name);
+  }
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  for (i = 1; i <= 200; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+            buffer));
+  }
+  for (j = 0; j < num_srcs; j++)
+    for (i = 1; i <= 200; i++)
+      fail_if (pull_mark (asinks[j]) != i);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  for (j = 0; j < num_srcs; j++)
+    g_object_unref (asinks[j]);
+  g_free (asinks);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("shared_task");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_shared_task);
+  tcase_add_test (tc, interpipe_shared_task_turns);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
@@ -0,0 +1,176 @@
+/* GStreamer
+ * Copyright (C) 2026 RidgeRun <support@ridgerun.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static void
+push_marked_buffer (GstElement * asrc, guint64 mark, gboolean delta)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_OFFSET (buffer) = mark;
+  if (delta)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+}
+
+static GstPadProbeReturn
+tag_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+  gint *tag_seen = user_data;
+  GstTagList *tags;
+  gchar *title = NULL;
+
+  if (GST_EVENT_TAG == GST_EVENT_TYPE (event)) {
+    gst_event_parse_tag (event, &tags);
+    if (gst_tag_list_get_string (tags, GST_TAG_TITLE, &title)
+        && 0 == g_strcmp0 (title, "replayed"))
+      g_atomic_int_set (tag_seen, 1);
+    g_free (title);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static guint64
+pull_mark (GstElement * asink)
+{
+  GstSample *outsample;
+  guint64 mark;
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  mark = GST_BUFFER_OFFSET (gst_sample_get_buffer (outsample));
+  gst_sample_unref (outsample);
+
+  return mark;
+}
+
+/*
+ * Given a node that already received a tag event, when a source
+ * switches to it then the tag event reaches the source pipeline before
+ * the first buffer.
+ */
+GST_START_TEST (interpipe_sticky_events_replay)
+{
+  GstPipeline *sink1;
+  GstPipeline *sink2;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstElement *intersink;
+  GstElement *intersrc;
+  GstPad *pad;
+  gint tag_seen = 0;
+  GError *error = NULL;
+
+  /* Create two sink pipelines */
+  sink1 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=stickysink1 async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink1), "asrc");
+  intersink = gst_bin_get_by_name (GST_BIN (sink1), "stickysink1");
+
+  sink2 =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=stickysink2 async=false", &error));
+  fail_if (error);
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=stickysink2 ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  pad = gst_element_get_static_pad (asink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, tag_probe,
+      &tag_seen, NULL);
+  gst_object_unref (pad);
+
+  /* Play the pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+
+  /* Tag the stream before anyone listens to it */
+  push_marked_buffer (asrc, 1, FALSE);
+  pad = gst_element_get_static_pad (intersink, "sink");
+  fail_unless (gst_pad_send_event (pad,
+          gst_event_new_tag (gst_tag_list_new (GST_TAG_TITLE, "replayed",
+                  NULL))));
+  gst_object_unref (pad);
+
+  /* The late listener gets the tag with its first buffer */
+  g_object_set (G_OBJECT (intersrc), "listen-to", "stickysink1", NULL);
+  push_marked_buffer (asrc, 2, FALSE);
+  fail_if (pull_mark (asink) != 2);
+  fail_unless (g_atomic_int_get (&tag_seen));
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink1), GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink2), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (intersink);
+  g_object_unref (intersrc);
+  g_object_unref (sink1);
+  g_object_unref (sink2);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_interpipe_suite (void)
+{
+  Suite *suite = suite_create ("Interpipe");
+  TCase *tc = tcase_create ("sticky_events_replay");
+
+  suite_add_tcase (suite, tc);
+  tcase_add_test (tc, interpipe_sticky_events_replay);
+
+  return suite;
+}
+
+GST_CHECK_MAIN (gst_interpipe);
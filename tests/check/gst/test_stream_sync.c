@@ -155,6 +155,255 @@ GST_START_TEST (interpipe_stream_sync_compensate_ts)
 
 GST_END_TEST;
 
+#if GST_CHECK_VERSION(1,8,0)
+/*
+ * Given a node started before the source, when the source compensates
+ * the running time, then the buffer reaches downstream untouched and
+ * its running time is translated through the segment.
+ */
+GST_START_TEST (interpipe_stream_sync_compensate_rt)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstSample *outsample;
+  GstBuffer *buffer;
+  GstClockTimeDiff offset;
+  GstClockTime running_time;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc format=time caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=rtsink async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=rtsink stream-sync=compensate-rt format=time ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  /* Play the node first so both base times differ */
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  g_usleep (100000);
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_get_state (GST_ELEMENT (src),
+          NULL, NULL, GST_CLOCK_TIME_NONE));
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = GST_SECOND;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          gst_buffer_ref (buffer)));
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+
+  /* Same buffer, same timestamp */
+  fail_if (gst_sample_get_buffer (outsample) != buffer);
+  fail_if (GST_BUFFER_PTS (gst_sample_get_buffer (outsample)) != GST_SECOND);
+
+  offset = GST_CLOCK_DIFF (gst_element_get_base_time (GST_ELEMENT (src)),
+      gst_element_get_base_time (GST_ELEMENT (sink)));
+  running_time = gst_segment_to_running_time (gst_sample_get_segment
+      (outsample), GST_FORMAT_TIME, GST_SECOND);
+  fail_if (running_time != GST_SECOND + offset);
+  gst_sample_unref (outsample);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  gst_buffer_unref (buffer);
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+/*
+ * Given a source compensating the running time while PLAYING, when its
+ * base time is changed then the next buffer is translated with the new
+ * one.
+ */
+GST_START_TEST (interpipe_stream_sync_compensate_rt_base_time_change)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *intersrc;
+  GstElement *asink;
+  GstSample *outsample;
+  GstBuffer *buffer;
+  GstClockTimeDiff offset;
+  GstClockTime running_time;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc format=time caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=basesink async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc name=intersrc listen-to=basesink stream-sync=compensate-rt "
+          "format=time ! appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  intersrc = gst_bin_get_by_name (GST_BIN (src), "intersrc");
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_get_state (GST_ELEMENT (src),
+          NULL, NULL, GST_CLOCK_TIME_NONE));
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = GST_SECOND;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  gst_sample_unref (outsample);
+
+  /* Move the base time of the source only, while PLAYING */
+  gst_element_set_base_time (intersrc,
+      gst_element_get_base_time (intersrc) + GST_SECOND);
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = 2 * GST_SECOND;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          buffer));
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+
+  offset = GST_CLOCK_DIFF (gst_element_get_base_time (intersrc),
+      gst_element_get_base_time (GST_ELEMENT (sink)));
+  running_time = gst_segment_to_running_time (gst_sample_get_segment
+      (outsample), GST_FORMAT_TIME, 2 * GST_SECOND);
+  fail_if (running_time != 2 * GST_SECOND + offset);
+  gst_sample_unref (outsample);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  g_object_unref (asrc);
+  g_object_unref (intersrc);
+  g_object_unref (asink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+
+/*
+ * Given a node with timestamps far ahead, when the source rebases them
+ * then the first buffer lands on the current running time and the
+ * spacing between buffers is kept.
+ */
+GST_START_TEST (interpipe_stream_sync_rebase_ts)
+{
+  GstPipeline *sink;
+  GstPipeline *src;
+  GstElement *asrc;
+  GstElement *asink;
+  GstSample *outsample;
+  GstBuffer *buffer;
+  GstClockTime first;
+  GstClockTime second;
+  GError *error = NULL;
+
+  /* Create the sink pipeline */
+  sink =
+      GST_PIPELINE (gst_parse_launch
+      ("appsrc name=asrc format=time caps=video/x-h264,stream-format=byte-stream,alignment=au ! "
+          "interpipesink name=rebasesink async=false", &error));
+  fail_if (error);
+  asrc = gst_bin_get_by_name (GST_BIN (sink), "asrc");
+
+  /* Create the source pipeline */
+  src =
+      GST_PIPELINE (gst_parse_launch
+      ("interpipesrc listen-to=rebasesink stream-sync=rebase-ts format=time ! "
+          "appsink name=asink async=false sync=false", &error));
+  fail_if (error);
+  asink = gst_bin_get_by_name (GST_BIN (src), "asink");
+
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_PLAYING));
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_get_state (GST_ELEMENT (src),
+          NULL, NULL, GST_CLOCK_TIME_NONE));
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = 100 * GST_SECOND;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          gst_buffer_ref (buffer)));
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  fail_if (gst_sample_get_buffer (outsample) != buffer);
+  first = gst_segment_to_running_time (gst_sample_get_segment (outsample),
+      GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+  gst_sample_unref (outsample);
+  gst_buffer_unref (buffer);
+
+  /* The first buffer starts close to the current running time */
+  fail_if (first >= 10 * GST_SECOND);
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (buffer) = 100 * GST_SECOND + 40 * GST_MSECOND;
+  fail_if (GST_FLOW_OK != gst_app_src_push_buffer (GST_APP_SRC (asrc),
+          gst_buffer_ref (buffer)));
+
+  outsample = gst_app_sink_pull_sample (GST_APP_SINK (asink));
+  fail_if (!outsample);
+  second = gst_segment_to_running_time (gst_sample_get_segment (outsample),
+      GST_FORMAT_TIME, GST_BUFFER_PTS (buffer));
+  gst_sample_unref (outsample);
+
+  /* The spacing of the node is kept */
+  fail_if (second - first != 40 * GST_MSECOND);
+
+  /* Stop pipelines */
+  fail_if (GST_STATE_CHANGE_FAILURE == gst_element_set_state (GST_ELEMENT (src),
+          GST_STATE_NULL));
+  fail_if (GST_STATE_CHANGE_FAILURE ==
+      gst_element_set_state (GST_ELEMENT (sink), GST_STATE_NULL));
+
+  /* Cleanup */
+  gst_buffer_unref (buffer);
+  g_object_unref (asrc);
+  g_object_unref (asink);
+  g_object_unref (sink);
+  g_object_unref (src);
+}
+
+GST_END_TEST;
+#endif
+
 static Suite *
 gst_interpipe_suite (void)
 {
@@ -163,6 +412,11 @@ gst_interpipe_suite (void)
 
   suite_add_tcase (suite, tc1);
   tcase_add_test (tc1, interpipe_stream_sync_compensate_ts);
+#if GST_CHECK_VERSION(1,8,0)
+  tcase_add_test (tc1, interpipe_stream_sync_compensate_rt);
+  tcase_add_test (tc1, interpipe_stream_sync_compensate_rt_base_time_change);
+  tcase_add_test (tc1, interpipe_stream_sync_rebase_ts);
+#endif
 
   return suite;
 }